@@ -0,0 +1,110 @@
+# distutils: language = c++
+from libcpp cimport bool
+from libcpp.memory cimport shared_ptr, unique_ptr
+from libcpp.string cimport string
+from libcpp.vector cimport vector
+from libc.stdint cimport uint32_t, int32_t, int64_t
+
+from pyarrow.includes.libarrow cimport CStatus, CMemoryPool, CSchema, CRecordBatch, CTable, CBuffer, CDataType, TimeUnit
+
+
+cdef extern from "native/column_decoder.h" namespace "pgarrow" nogil:
+    cdef enum class CTypeKind" pgarrow::type_kind":
+        base
+        array
+        vector
+        composite
+        range
+        hstore
+        postgis
+
+    cdef cppclass CColumnSpec" pgarrow::column_spec":
+        string name
+        uint32_t oid
+        int32_t typmod
+        vector[string] enum_labels
+        CTypeKind kind
+        vector[CColumnSpec] children
+        vector[int32_t] dims
+        bool json_struct
+        shared_ptr[CDataType] json_type
+
+
+    cdef enum class CValuePolicy" pgarrow::value_policy":
+        error
+        null
+
+    cdef cppclass CTypeOptions" pgarrow::type_options":
+        bool string_view
+        bool large_strings
+        bool strings_as_dictionary
+        int32_t dictionary_max_size
+        int32_t numeric_precision
+        int32_t numeric_scale
+        CValuePolicy numeric_overflow
+        CValuePolicy numeric_special
+        TimeUnit time_unit
+        string timezone
+        bool infinity_as_null
+        int64_t timestamp_infinity
+        int64_t timestamp_neg_infinity
+        int32_t date_infinity
+        int32_t date_neg_infinity
+        CValuePolicy time_overflow
+        bool large_lists
+        bool fixed_size_arrays
+
+
+cdef extern from "native/copy_decoder.h" namespace "pgarrow" nogil:
+    cdef enum class CParallelMode" pgarrow::parallel_mode":
+        automatic
+        columns
+        chunks
+
+    cdef cppclass CDecodeOptions" pgarrow::decode_options":
+        bool use_threads
+        CParallelMode parallel
+        int64_t window_size
+        int64_t chunk_size
+        int64_t expected_rows
+        CTypeOptions types
+
+    cdef cppclass CCopyDecoder" pgarrow::copy_decoder":
+        @staticmethod
+        CStatus make(const vector[CColumnSpec]& columns, const CDecodeOptions& options,
+                     CMemoryPool* pool, unique_ptr[CCopyDecoder]* out)
+
+        CStatus decode(const char* data, int64_t size, int64_t* consumed)
+        CStatus decode(const char* data, int64_t size, int64_t* consumed, int64_t row_limit)
+        CStatus decode_table(const char* data, int64_t size, shared_ptr[CTable]* out)
+        void set_source(shared_ptr[CBuffer] source)
+        CStatus flush(shared_ptr[CRecordBatch]* out)
+        CStatus make_table(const vector[shared_ptr[CRecordBatch]]& batches, shared_ptr[CTable]* out)
+        CStatus finish_table(shared_ptr[CTable]* out)
+        bool finished()
+        int64_t num_rows()
+        shared_ptr[CSchema] schema()
+
+
+cdef extern from "native/mapped_file.h" namespace "pgarrow" nogil:
+    cdef cppclass CMappedFile" pgarrow::mapped_file"(CBuffer):
+        @staticmethod
+        CStatus open(const string& path, shared_ptr[CMappedFile]* out)
+
+    CStatus decode_mapped_file(CCopyDecoder* decoder, const shared_ptr[CMappedFile]& file,
+                               shared_ptr[CTable]* out)
+
+
+cdef extern from "native/arena_pool.h" namespace "pgarrow" nogil:
+    cdef cppclass CArenaOptions" pgarrow::arena_options":
+        int64_t arena_size
+        bool huge_pages
+        bool transparent_huge_pages
+
+    cdef cppclass CArenaMemoryPool" pgarrow::arena_memory_pool"(CMemoryPool):
+        @staticmethod
+        CStatus make(const CArenaOptions& options, unique_ptr[CArenaMemoryPool]* out)
+
+        int64_t mapped_bytes()
+        double fragmentation()
+        void orphan()
@@ -1,4 +1,7 @@
+#pragma once
+
 #include <stdint.h>
+#include <string.h>
 
 #if defined(__linux__) || defined(__CYGWIN__)
 #include <endian.h>
@@ -219,3 +222,345 @@ unpack_double(const char *buf)
     v.i = (uint64_t)unpack_int64(buf);
     return v.f;
 }
+
+
+/*
+ * Bulk conversion of big-endian values into native order, used by the
+ * column decoders. The *_array variants convert n consecutive values at src
+ * (src and dst may be the same buffer); the *_strided variants read values
+ * which are `stride` bytes apart, as consecutive fields of fixed size
+ * tuples are.
+ *
+ * On x86 the kernels use SSE4.1, AVX2 or AVX-512 byte shuffles (and
+ * gathers for strided input), picked at runtime from what the CPU
+ * supports. Elsewhere they fall back to the scalar functions above.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) \
+    && __BYTE_ORDER == __LITTLE_ENDIAN
+#define APG_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+#if APG_X86_SIMD
+
+enum {
+    APG_SIMD_NONE = 0,
+    APG_SIMD_SSE41 = 1,
+    APG_SIMD_AVX2 = 2,
+    APG_SIMD_AVX512 = 3
+};
+
+static inline int
+apg_simd_level(void)
+{
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return APG_SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return APG_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return APG_SIMD_SSE41;
+    }
+    return APG_SIMD_NONE;
+}
+
+/* pshufb masks reversing the bytes of each 2, 4 and 8 byte lane */
+#define APG_BSWAP16_MASK 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+#define APG_BSWAP32_MASK 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+#define APG_BSWAP64_MASK 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7
+
+
+/* Contiguous kernels: the same loop for each width, only the mask differs */
+
+#define APG_DEFINE_BSWAP_ARRAY(width, mask)                                      \
+__attribute__((target("sse4.1"))) static inline int64_t                          \
+apg_bswap##width##_array_sse41(char *dst, const char *src, int64_t n)            \
+{                                                                                \
+    const __m128i shuffle = _mm_set_epi8(mask);                                  \
+    int64_t per_vector = 16 / (width / 8), i = 0;                                \
+    for (; i + per_vector <= n; i += per_vector) {                               \
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * (width / 8)));   \
+        _mm_storeu_si128((__m128i *)(dst + i * (width / 8)),                     \
+                         _mm_shuffle_epi8(v, shuffle));                          \
+    }                                                                            \
+    return i;                                                                    \
+}                                                                                \
+                                                                                 \
+__attribute__((target("avx2"))) static inline int64_t                            \
+apg_bswap##width##_array_avx2(char *dst, const char *src, int64_t n)             \
+{                                                                                \
+    const __m256i shuffle = _mm256_set_epi8(mask, mask);                         \
+    int64_t per_vector = 32 / (width / 8), i = 0;                                \
+    for (; i + per_vector <= n; i += per_vector) {                               \
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * (width / 8)));\
+        _mm256_storeu_si256((__m256i *)(dst + i * (width / 8)),                  \
+                            _mm256_shuffle_epi8(v, shuffle));                    \
+    }                                                                            \
+    return i;                                                                    \
+}                                                                                \
+                                                                                 \
+__attribute__((target("avx512f,avx512bw"))) static inline int64_t                \
+apg_bswap##width##_array_avx512(char *dst, const char *src, int64_t n)           \
+{                                                                                \
+    const __m512i shuffle = _mm512_maskz_broadcast_i32x4(0xffff, _mm_set_epi8(mask));          \
+    int64_t per_vector = 64 / (width / 8), i = 0;                                \
+    for (; i + per_vector <= n; i += per_vector) {                               \
+        __m512i v = _mm512_loadu_si512((const void *)(src + i * (width / 8)));   \
+        _mm512_storeu_si512((void *)(dst + i * (width / 8)),                     \
+                            _mm512_shuffle_epi8(v, shuffle));                    \
+    }                                                                            \
+    return i;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline int64_t                                                            \
+apg_bswap##width##_array_simd(char *dst, const char *src, int64_t n)             \
+{                                                                                \
+    switch (apg_simd_level()) {                                                  \
+        case APG_SIMD_AVX512:                                                    \
+            return apg_bswap##width##_array_avx512(dst, src, n);                 \
+        case APG_SIMD_AVX2:                                                      \
+            return apg_bswap##width##_array_avx2(dst, src, n);                   \
+        case APG_SIMD_SSE41:                                                     \
+            return apg_bswap##width##_array_sse41(dst, src, n);                  \
+        default:                                                                 \
+            return 0;                                                            \
+    }                                                                            \
+}
+
+APG_DEFINE_BSWAP_ARRAY(16, APG_BSWAP16_MASK)
+APG_DEFINE_BSWAP_ARRAY(32, APG_BSWAP32_MASK)
+APG_DEFINE_BSWAP_ARRAY(64, APG_BSWAP64_MASK)
+
+
+/* Strided kernels: gather the values into a vector, then shuffle */
+
+__attribute__((target("sse4.1"))) static inline int64_t
+apg_bswap16_strided_sse41(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m128i shuffle = _mm_set_epi8(APG_BSWAP16_MASK);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const char *p = src + i * stride;
+        uint16_t v[8];
+        int k;
+        for (k = 0; k < 8; ++k) {
+            memcpy(&v[k], p + k * stride, 2);
+        }
+        _mm_storeu_si128((__m128i *)(dst + i * 2),
+                         _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)v), shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1"))) static inline int64_t
+apg_bswap32_strided_sse41(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m128i shuffle = _mm_set_epi8(APG_BSWAP32_MASK);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const char *p = src + i * stride;
+        uint32_t v4[4];
+        memcpy(&v4[0], p, 4);
+        memcpy(&v4[1], p + stride, 4);
+        memcpy(&v4[2], p + 2 * stride, 4);
+        memcpy(&v4[3], p + 3 * stride, 4);
+        __m128i v = _mm_loadu_si128((const __m128i *)v4);
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1"))) static inline int64_t
+apg_bswap64_strided_sse41(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m128i shuffle = _mm_set_epi8(APG_BSWAP64_MASK);
+    int64_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const char *p = src + i * stride;
+        __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                                       _mm_loadl_epi64((const __m128i *)(p + stride)));
+        _mm_storeu_si128((__m128i *)(dst + i * 8), _mm_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static inline int64_t
+apg_bswap32_strided_avx2(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m256i shuffle = _mm256_set_epi8(APG_BSWAP32_MASK, APG_BSWAP32_MASK);
+    const __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                             _mm256_set1_epi32((int32_t)stride));
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_i32gather_epi32((const int *)(src + i * stride), index, 1);
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static inline int64_t
+apg_bswap64_strided_avx2(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m256i shuffle = _mm256_set_epi8(APG_BSWAP64_MASK, APG_BSWAP64_MASK);
+    const __m256i index = _mm256_setr_epi64x(0, stride, 2 * stride, 3 * stride);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_i64gather_epi64((const long long *)(src + i * stride), index, 1);
+        _mm256_storeu_si256((__m256i *)(dst + i * 8), _mm256_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw"))) static inline int64_t
+apg_bswap32_strided_avx512(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m512i shuffle = _mm512_maskz_broadcast_i32x4(0xffff, _mm_set_epi8(APG_BSWAP32_MASK));
+    const __m512i index = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32((int32_t)stride));
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, index,
+                                                (const void *)(src + i * stride), 1);
+        _mm512_storeu_si512((void *)(dst + i * 4), _mm512_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw"))) static inline int64_t
+apg_bswap64_strided_avx512(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    const __m512i shuffle = _mm512_maskz_broadcast_i32x4(0xffff, _mm_set_epi8(APG_BSWAP64_MASK));
+    const __m512i index = _mm512_setr_epi64(0, stride, 2 * stride, 3 * stride,
+                                            4 * stride, 5 * stride, 6 * stride, 7 * stride);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xff, index,
+                                                (const void *)(src + i * stride), 1);
+        _mm512_storeu_si512((void *)(dst + i * 8), _mm512_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+static inline int64_t
+apg_bswap16_strided_simd(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    /* there is no 16 bit gather, the SSE kernel serves all levels */
+    return apg_simd_level() >= APG_SIMD_SSE41 ? apg_bswap16_strided_sse41(dst, src, stride, n) : 0;
+}
+
+static inline int64_t
+apg_bswap32_strided_simd(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    /* gather indexes are 32 bit, keep them in range */
+    if (stride > (INT32_MAX >> 4)) {
+        return 0;
+    }
+    switch (apg_simd_level()) {
+        case APG_SIMD_AVX512:
+            return apg_bswap32_strided_avx512(dst, src, stride, n);
+        case APG_SIMD_AVX2:
+            return apg_bswap32_strided_avx2(dst, src, stride, n);
+        case APG_SIMD_SSE41:
+            return apg_bswap32_strided_sse41(dst, src, stride, n);
+        default:
+            return 0;
+    }
+}
+
+static inline int64_t
+apg_bswap64_strided_simd(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    switch (apg_simd_level()) {
+        case APG_SIMD_AVX512:
+            return apg_bswap64_strided_avx512(dst, src, stride, n);
+        case APG_SIMD_AVX2:
+            return apg_bswap64_strided_avx2(dst, src, stride, n);
+        case APG_SIMD_SSE41:
+            return apg_bswap64_strided_sse41(dst, src, stride, n);
+        default:
+            return 0;
+    }
+}
+
+#else
+
+#define apg_bswap16_array_simd(dst, src, n) ((int64_t)0)
+#define apg_bswap32_array_simd(dst, src, n) ((int64_t)0)
+#define apg_bswap64_array_simd(dst, src, n) ((int64_t)0)
+#define apg_bswap16_strided_simd(dst, src, stride, n) ((int64_t)0)
+#define apg_bswap32_strided_simd(dst, src, stride, n) ((int64_t)0)
+#define apg_bswap64_strided_simd(dst, src, stride, n) ((int64_t)0)
+
+#endif
+
+
+/* Public bulk API: SIMD for the bulk of the values, scalar for the tail */
+
+static inline void
+unpack_int16_array(char *dst, const char *src, int64_t n)
+{
+    int64_t i = apg_bswap16_array_simd(dst, src, n);
+    for (; i < n; ++i) {
+        int16_t v = unpack_int16(src + i * 2);
+        memcpy(dst + i * 2, &v, 2);
+    }
+}
+
+
+static inline void
+unpack_int32_array(char *dst, const char *src, int64_t n)
+{
+    int64_t i = apg_bswap32_array_simd(dst, src, n);
+    for (; i < n; ++i) {
+        int32_t v = unpack_int32(src + i * 4);
+        memcpy(dst + i * 4, &v, 4);
+    }
+}
+
+
+static inline void
+unpack_int64_array(char *dst, const char *src, int64_t n)
+{
+    int64_t i = apg_bswap64_array_simd(dst, src, n);
+    for (; i < n; ++i) {
+        int64_t v = unpack_int64(src + i * 8);
+        memcpy(dst + i * 8, &v, 8);
+    }
+}
+
+
+static inline void
+unpack_int16_strided(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    int64_t i = apg_bswap16_strided_simd(dst, src, stride, n);
+    for (; i < n; ++i) {
+        int16_t v = unpack_int16(src + i * stride);
+        memcpy(dst + i * 2, &v, 2);
+    }
+}
+
+
+static inline void
+unpack_int32_strided(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    int64_t i = apg_bswap32_strided_simd(dst, src, stride, n);
+    for (; i < n; ++i) {
+        int32_t v = unpack_int32(src + i * stride);
+        memcpy(dst + i * 4, &v, 4);
+    }
+}
+
+
+static inline void
+unpack_int64_strided(char *dst, const char *src, int64_t stride, int64_t n)
+{
+    int64_t i = apg_bswap64_strided_simd(dst, src, stride, n);
+    for (; i < n; ++i) {
+        int64_t v = unpack_int64(src + i * stride);
+        memcpy(dst + i * 8, &v, 8);
+    }
+}
@@ -0,0 +1,156 @@
+#include "address_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+arrow::FieldVector inet_fields()
+{
+    return {arrow::field("family", arrow::uint8(), false), arrow::field("prefix_length", arrow::uint8(), false),
+            arrow::field("address", arrow::fixed_size_binary(16), false)};
+}
+
+arrow::FieldVector tid_fields()
+{
+    return {arrow::field("block", arrow::uint32(), false), arrow::field("offset", arrow::uint16(), false)};
+}
+
+}
+
+inet_decoder::inet_decoder(std::string name, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    families_(pool),
+    prefix_lengths_(pool),
+    addresses_(pool),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> inet_decoder::type() const
+{
+    return arrow::struct_(inet_fields());
+}
+
+arrow::Status inet_decoder::append(const char* data, int32_t length)
+{
+    if (length < INET_HEADER_SIZE) {
+        return arrow::Status::Invalid("corrupt inet field in column '", name_, "'");
+    }
+    auto const family = static_cast<uint8_t>(data[0]);
+    auto const address_length = static_cast<uint8_t>(data[3]);
+    pg_bytes<16>::c_type address{};
+    if (family == PGSQL_AF_INET && address_length == 4 && length == INET_HEADER_SIZE + 4) {
+        address[10] = address[11] = 0xff;
+        std::memcpy(address.data() + 12, data + INET_HEADER_SIZE, 4);
+    } else if (family == PGSQL_AF_INET6 && address_length == 16 && length == INET_HEADER_SIZE + 16) {
+        std::memcpy(address.data(), data + INET_HEADER_SIZE, 16);
+    } else {
+        return arrow::Status::Invalid("corrupt inet field in column '", name_, "'");
+    }
+    ARROW_RETURN_NOT_OK(families_.Append(family == PGSQL_AF_INET ? 4 : 6));
+    ARROW_RETURN_NOT_OK(prefix_lengths_.Append(static_cast<uint8_t>(data[1])));
+    ARROW_RETURN_NOT_OK(addresses_.Append(address));
+    return validity_.append_valid();
+}
+
+arrow::Status inet_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(families_.Append(0));
+    ARROW_RETURN_NOT_OK(prefix_lengths_.Append(0));
+    ARROW_RETURN_NOT_OK(addresses_.Append(pg_bytes<16>::c_type{}));
+    return validity_.append_null();
+}
+
+arrow::Status inet_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(families_.Reserve(n));
+    ARROW_RETURN_NOT_OK(prefix_lengths_.Reserve(n));
+    ARROW_RETURN_NOT_OK(addresses_.Reserve(n));
+    return validity_.reserve(n);
+}
+
+arrow::Status inet_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> families;
+    std::shared_ptr<arrow::Buffer> prefix_lengths;
+    std::shared_ptr<arrow::Buffer> addresses;
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(families_.Finish(&families));
+    ARROW_RETURN_NOT_OK(prefix_lengths_.Finish(&prefix_lengths));
+    ARROW_RETURN_NOT_OK(addresses_.Finish(&addresses));
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    std::vector<std::shared_ptr<arrow::ArrayData>> children = {
+        arrow::ArrayData::Make(arrow::uint8(), length, {nullptr, families}, 0),
+        arrow::ArrayData::Make(arrow::uint8(), length, {nullptr, prefix_lengths}, 0),
+        arrow::ArrayData::Make(arrow::fixed_size_binary(16), length, {nullptr, addresses}, 0)};
+    *out = arrow::MakeArray(arrow::ArrayData::Make(type(), length, {validity}, std::move(children), null_count));
+    return arrow::Status::OK();
+}
+
+tid_decoder::tid_decoder(arrow::MemoryPool* pool) :
+    blocks_(pool),
+    offsets_(pool),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> tid_decoder::type() const
+{
+    return arrow::struct_(tid_fields());
+}
+
+arrow::Status tid_decoder::append(const char* data, int32_t length)
+{
+    if (length != WIDTH) {
+        return arrow::Status::Invalid("expected field of ", WIDTH, " bytes for tid, got ", length);
+    }
+    ARROW_RETURN_NOT_OK(blocks_.Append(static_cast<uint32_t>(unpack_int32(data))));
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<uint16_t>(unpack_int16(data + 4))));
+    return validity_.append_valid();
+}
+
+arrow::Status tid_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(blocks_.Append(0));
+    ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    return validity_.append_null();
+}
+
+arrow::Status tid_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(blocks_.Reserve(n));
+    ARROW_RETURN_NOT_OK(offsets_.Reserve(n));
+    return validity_.reserve(n);
+}
+
+arrow::Status tid_decoder::append_strided(const char* data, int64_t stride, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(reserve(n));
+    for (int64_t i = 0; i < n; ++i) {
+        const char* field = data + i * stride;
+        blocks_.UnsafeAppend(static_cast<uint32_t>(unpack_int32(field)));
+        offsets_.UnsafeAppend(static_cast<uint16_t>(unpack_int16(field + 4)));
+    }
+    return validity_.append_valid(n);
+}
+
+arrow::Status tid_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> blocks;
+    std::shared_ptr<arrow::Buffer> offsets;
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(blocks_.Finish(&blocks));
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    std::vector<std::shared_ptr<arrow::ArrayData>> children = {
+        arrow::ArrayData::Make(arrow::uint32(), length, {nullptr, blocks}, 0),
+        arrow::ArrayData::Make(arrow::uint16(), length, {nullptr, offsets}, 0)};
+    *out = arrow::MakeArray(arrow::ArrayData::Make(type(), length, {validity}, std::move(children), null_count));
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of inet and cidr in the send format (see inet_send in PG's
+ * utils/adt/network.c): uint8 family, uint8 prefix length in bits, uint8
+ * is_cidr, uint8 address length, then the address in network order.
+ */
+constexpr int32_t INET_HEADER_SIZE = 4;
+constexpr uint8_t PGSQL_AF_INET = 2;
+constexpr uint8_t PGSQL_AF_INET6 = 3;
+
+/**
+ * @brief Decoder for inet and cidr columns into struct<family: uint8,
+ *        prefix_length: uint8, address: fixed_size_binary(16)> arrays.
+ *
+ * family is 4 or 6. IPv4 addresses are stored IPv4-mapped
+ * (::ffff:a.b.c.d), so that all addresses compare and join as 16 bytes.
+ */
+class inet_decoder : public column_decoder {
+  public:
+    inet_decoder(std::string name, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    std::string name_;
+    arrow::TypedBufferBuilder<uint8_t> families_;
+    arrow::TypedBufferBuilder<uint8_t> prefix_lengths_;
+    arrow::TypedBufferBuilder<pg_bytes<16>::c_type> addresses_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Decoder for tid columns (such as ctid) into struct<block: uint32,
+ *        offset: uint16> arrays
+ */
+class tid_decoder : public column_decoder {
+  public:
+    explicit tid_decoder(arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+    int32_t fixed_width() const override { return WIDTH; }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status append_strided(const char* data, int64_t stride, int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    // uint32 block number and uint16 line pointer offset
+    static constexpr int32_t WIDTH = 6;
+
+    arrow::TypedBufferBuilder<uint32_t> blocks_;
+    arrow::TypedBufferBuilder<uint16_t> offsets_;
+    validity_bitmap validity_;
+};
+
+}
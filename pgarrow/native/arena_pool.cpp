@@ -0,0 +1,272 @@
+#include "arena_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+namespace pgarrow {
+
+namespace {
+
+// step in which large buffers are mapped, the usual huge page size
+constexpr int64_t HUGE_PAGE_SIZE = int64_t(2) << 20;
+// room kept for the arena header, so buffers stay 64 byte aligned
+constexpr int64_t ARENA_HEADER_SIZE = 64;
+
+alignas(arrow::kDefaultBufferAlignment) uint8_t zero_size_area[1];
+
+int64_t round_up(int64_t size, int64_t step)
+{
+    return (size + step - 1) / step * step;
+}
+
+}
+
+/*
+ * Header at the start of every arena
+ */
+struct arena_memory_pool::arena {
+    // bytes handed out, including the header
+    int64_t used;
+    // buffers handed out and not freed yet
+    int64_t live;
+};
+
+arena_memory_pool::arena_memory_pool(const arena_options& options) :
+    options_(options),
+    current_(nullptr),
+    mapped_bytes_(0),
+    refs_(1)
+{
+}
+
+arrow::Status arena_memory_pool::make(const arena_options& options, std::unique_ptr<arena_memory_pool>* out)
+{
+#if defined(_WIN32)
+    return arrow::Status::NotImplemented("arena memory pools are not supported on this platform");
+#else
+    int64_t const size = options.arena_size;
+    if (size < HUGE_PAGE_SIZE || (size & (size - 1)) != 0) {
+        return arrow::Status::Invalid("arena size must be a power of two of at least 2 MB, got ", size);
+    }
+    out->reset(new arena_memory_pool(options));
+    return arrow::Status::OK();
+#endif
+}
+
+arena_memory_pool::~arena_memory_pool()
+{
+    // every other arena and large buffer was unmapped with its last buffer
+    ReleaseUnused();
+}
+
+#if defined(_WIN32)
+
+arrow::Status arena_memory_pool::map(int64_t, uint8_t**)
+{
+    return arrow::Status::NotImplemented("arena memory pools are not supported on this platform");
+}
+
+void arena_memory_pool::unmap(uint8_t*, int64_t)
+{
+}
+
+#else
+
+arrow::Status arena_memory_pool::map(int64_t size, uint8_t** out)
+{
+    void* data = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if (options_.huge_pages) {
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (data == MAP_FAILED) {
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            return arrow::Status::OutOfMemory("failed to map ", size, " bytes: ", std::strerror(errno));
+        }
+#if defined(MADV_HUGEPAGE)
+        if (options_.transparent_huge_pages) {
+            ::madvise(data, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    mapped_bytes_ += size;
+    *out = static_cast<uint8_t*>(data);
+    return arrow::Status::OK();
+}
+
+void arena_memory_pool::unmap(uint8_t* data, int64_t size)
+{
+    ::munmap(data, size);
+    mapped_bytes_ -= size;
+}
+
+#endif
+
+arrow::Status arena_memory_pool::new_arena()
+{
+    // map twice the size to cut an arena aligned to its size out of it
+    int64_t const size = options_.arena_size;
+    uint8_t* data;
+    ARROW_RETURN_NOT_OK(map(2 * size, &data));
+    auto const start = reinterpret_cast<uintptr_t>(data);
+    auto const aligned = (start + size - 1) & ~static_cast<uintptr_t>(size - 1);
+    int64_t const head = static_cast<int64_t>(aligned - start);
+    if (head > 0) {
+        unmap(data, head);
+    }
+    unmap(reinterpret_cast<uint8_t*>(aligned) + size, size - head);
+
+    if (current_ != nullptr && current_->live == 0) {
+        unmap(reinterpret_cast<uint8_t*>(current_), size);
+    }
+    current_ = new (reinterpret_cast<void*>(aligned)) arena{ARENA_HEADER_SIZE, 0};
+    return arrow::Status::OK();
+}
+
+arrow::Status arena_memory_pool::allocate_small(int64_t size, int64_t alignment, uint8_t** out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t offset = 0;
+    if (current_ != nullptr) {
+        offset = round_up(current_->used, alignment);
+    }
+    if (current_ == nullptr || offset + size > options_.arena_size) {
+        // the full arena lives on until its last buffer is freed
+        ARROW_RETURN_NOT_OK(new_arena());
+        offset = round_up(current_->used, alignment);
+    }
+    current_->used = offset + size;
+    ++current_->live;
+    *out = reinterpret_cast<uint8_t*>(current_) + offset;
+    return arrow::Status::OK();
+}
+
+void arena_memory_pool::free_small(uint8_t* buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto a = reinterpret_cast<arena*>(reinterpret_cast<uintptr_t>(buffer) &
+                                      ~static_cast<uintptr_t>(options_.arena_size - 1));
+    if (--a->live > 0) {
+        return;
+    }
+    if (a == current_) {
+        a->used = ARENA_HEADER_SIZE;
+    } else {
+        unmap(reinterpret_cast<uint8_t*>(a), options_.arena_size);
+    }
+}
+
+arrow::Status arena_memory_pool::Allocate(int64_t size, int64_t alignment, uint8_t** out)
+{
+    if (size < 0) {
+        return arrow::Status::Invalid("negative allocation size ", size);
+    }
+    if (size == 0) {
+        *out = zero_size_area;
+        return arrow::Status::OK();
+    }
+    if (is_large(size)) {
+        ARROW_RETURN_NOT_OK(map(round_up(size, HUGE_PAGE_SIZE), out));
+    } else {
+        ARROW_RETURN_NOT_OK(allocate_small(size, alignment, out));
+    }
+    stats_.DidAllocateBytes(size);
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    return arrow::Status::OK();
+}
+
+void arena_memory_pool::Free(uint8_t* buffer, int64_t size, int64_t alignment)
+{
+    if (buffer == zero_size_area) {
+        return;
+    }
+    if (is_large(size)) {
+        unmap(buffer, round_up(size, HUGE_PAGE_SIZE));
+    } else {
+        free_small(buffer);
+    }
+    stats_.DidFreeBytes(size);
+    // may delete the pool if it was orphaned
+    release();
+}
+
+arrow::Status arena_memory_pool::Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                                            uint8_t** ptr)
+{
+    if (new_size < 0) {
+        return arrow::Status::Invalid("negative allocation size ", new_size);
+    }
+    if (*ptr == zero_size_area) {
+        return Allocate(new_size, alignment, ptr);
+    }
+    if (new_size == 0) {
+        Free(*ptr, old_size, alignment);
+        *ptr = zero_size_area;
+        return arrow::Status::OK();
+    }
+
+    if (is_large(old_size) && is_large(new_size)) {
+        int64_t const old_mapped = round_up(old_size, HUGE_PAGE_SIZE);
+        int64_t const new_mapped = round_up(new_size, HUGE_PAGE_SIZE);
+        if (old_mapped == new_mapped) {
+            stats_.DidReallocateBytes(old_size, new_size);
+            return arrow::Status::OK();
+        }
+#if defined(__linux__)
+        // let the kernel move the pages instead of copying them
+        void* data = ::mremap(*ptr, old_mapped, new_mapped, MREMAP_MAYMOVE);
+        if (data != MAP_FAILED) {
+            mapped_bytes_ += new_mapped - old_mapped;
+            stats_.DidReallocateBytes(old_size, new_size);
+            *ptr = static_cast<uint8_t*>(data);
+            return arrow::Status::OK();
+        }
+#endif
+    } else if (!is_large(old_size) && !is_large(new_size)) {
+        // the last buffer of the current arena can grow or shrink in place
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const offset = static_cast<int64_t>(reinterpret_cast<uintptr_t>(*ptr) -
+                                                 reinterpret_cast<uintptr_t>(current_));
+        if (current_ != nullptr && offset > 0 && offset + old_size == current_->used &&
+            offset + new_size <= options_.arena_size) {
+            current_->used = offset + new_size;
+            stats_.DidReallocateBytes(old_size, new_size);
+            return arrow::Status::OK();
+        }
+    }
+
+    uint8_t* data;
+    ARROW_RETURN_NOT_OK(Allocate(new_size, alignment, &data));
+    std::memcpy(data, *ptr, static_cast<size_t>(std::min(old_size, new_size)));
+    Free(*ptr, old_size, alignment);
+    *ptr = data;
+    return arrow::Status::OK();
+}
+
+void arena_memory_pool::ReleaseUnused()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_ != nullptr && current_->live == 0) {
+        unmap(reinterpret_cast<uint8_t*>(current_), options_.arena_size);
+        current_ = nullptr;
+    }
+}
+
+double arena_memory_pool::fragmentation() const
+{
+    int64_t const mapped = mapped_bytes();
+    if (mapped == 0) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(bytes_allocated()) / static_cast<double>(mapped);
+}
+
+}
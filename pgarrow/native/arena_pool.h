@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <arrow/api.h>
+
+namespace pgarrow {
+
+/**
+ * @brief Settings of an arena_memory_pool
+ */
+struct arena_options {
+    /// bytes mapped per arena, a power of two and a multiple of 2 MB.
+    /// Allocations of an eighth of this or more get a mapping of their own.
+    int64_t arena_size = int64_t(64) << 20;
+    /// map explicitly reserved huge pages (MAP_HUGETLB), falling back to
+    /// normal pages when none are available
+    bool huge_pages = false;
+    /// ask for transparent huge pages on mappings of normal pages
+    bool transparent_huge_pages = true;
+};
+
+/**
+ * @brief Memory pool for column buffers that maps memory from the kernel in
+ *        large, huge page friendly pieces.
+ *
+ * Small buffers are carved out of arenas of arena_size bytes, aligned to
+ * their size so a pointer leads straight back to its arena; an arena is
+ * unmapped once its last buffer is freed. Large buffers get a mapping of
+ * their own in 2 MB steps, which grows with mremap() rather than by
+ * copying. Either way the decoder touches few, large mappings, which keeps
+ * TLB misses and page faults down on big loads.
+ *
+ * Buffers only keep a plain pointer to their pool, so an owner that goes
+ * away before them hands the pool over with orphan() instead of destroying
+ * it: each live buffer holds a reference, and the last one freed deletes
+ * the pool along with whatever it still has mapped.
+ */
+class arena_memory_pool : public arrow::MemoryPool {
+  public:
+    static arrow::Status make(const arena_options& options, std::unique_ptr<arena_memory_pool>* out);
+
+    /**
+     * @brief Unmap what no buffer is left in; only to be reached once all
+     *        buffers are freed, see orphan()
+     */
+    ~arena_memory_pool() override;
+
+    /**
+     * @brief Give up the owner's reference, deleting the pool now if no
+     *        buffer is live or else once the last is freed. The pool must
+     *        not be used by the owner afterwards.
+     */
+    void orphan() { release(); }
+
+    arrow::Status Allocate(int64_t size, int64_t alignment, uint8_t** out) override;
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                             uint8_t** ptr) override;
+    void Free(uint8_t* buffer, int64_t size, int64_t alignment) override;
+    void ReleaseUnused() override;
+
+    int64_t bytes_allocated() const override { return stats_.bytes_allocated(); }
+    int64_t max_memory() const override { return stats_.max_memory(); }
+    int64_t total_bytes_allocated() const override { return stats_.total_bytes_allocated(); }
+    int64_t num_allocations() const override { return stats_.num_allocations(); }
+    std::string backend_name() const override { return "pgarrow-arena"; }
+
+    /**
+     * @brief Bytes currently mapped from the kernel
+     */
+    int64_t mapped_bytes() const { return mapped_bytes_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Share of the mapped bytes not holding a live buffer, from
+     *        partly used arenas and large buffers rounded up to 2 MB
+     */
+    double fragmentation() const;
+
+  private:
+    struct arena;
+
+    explicit arena_memory_pool(const arena_options& options);
+
+    bool is_large(int64_t size) const { return size >= options_.arena_size / 8; }
+
+    arrow::Status map(int64_t size, uint8_t** out);
+    void unmap(uint8_t* data, int64_t size);
+
+    /**
+     * @brief Drop a reference, deleting the pool with the last
+     */
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    arrow::Status allocate_small(int64_t size, int64_t alignment, uint8_t** out);
+    void free_small(uint8_t* buffer);
+    arrow::Status new_arena();
+
+    arena_options options_;
+    // guards the arenas, large buffers are mapped without it
+    std::mutex mutex_;
+    arena* current_;
+    arrow::internal::MemoryPoolStats stats_;
+    std::atomic<int64_t> mapped_bytes_;
+    // the owner's reference until orphan(), plus one per live buffer
+    std::atomic<int64_t> refs_;
+};
+
+}
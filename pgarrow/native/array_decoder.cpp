@@ -0,0 +1,252 @@
+#include "array_decoder.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <arrow/extension/fixed_shape_tensor.h>
+
+namespace pgarrow {
+
+namespace {
+
+arrow::Status corrupt_array(const std::string& name)
+{
+    return arrow::Status::Invalid("corrupt array field in column '", name, "'");
+}
+
+std::string shape_string(const int32_t* dims, std::size_t ndim)
+{
+    std::ostringstream out;
+    out << '[';
+    for (std::size_t i = 0; i < ndim; ++i) {
+        out << (i ? ", " : "") << dims[i];
+    }
+    out << ']';
+    return out.str();
+}
+
+}
+
+arrow::Status parse_array_header(const char* data, int32_t length, const std::string& name, array_header* out)
+{
+    if (length < ARRAY_HEADER_SIZE) {
+        return corrupt_array(name);
+    }
+    out->ndim = unpack_int32(data);
+    out->has_nulls = unpack_int32(data + 4) != 0;
+    out->element_oid = static_cast<uint32_t>(unpack_int32(data + 8));
+    if (out->ndim < 0 || out->ndim > ARRAY_MAX_DIMS) {
+        return corrupt_array(name);
+    }
+    int32_t const header_size = ARRAY_HEADER_SIZE + out->ndim * ARRAY_DIM_SIZE;
+    if (length < header_size) {
+        return corrupt_array(name);
+    }
+    int64_t count = out->ndim > 0 ? 1 : 0;
+    for (int32_t d = 0; d < out->ndim; ++d) {
+        out->dims[d] = unpack_int32(data + ARRAY_HEADER_SIZE + d * ARRAY_DIM_SIZE);
+        if (out->dims[d] < 0) {
+            return corrupt_array(name);
+        }
+        count *= out->dims[d];
+        // every element takes at least its length word; checked per
+        // dimension, so the product of the next one cannot overflow
+        if (count > (length - header_size) / 4) {
+            return corrupt_array(name);
+        }
+    }
+    out->count = static_cast<int32_t>(count);
+    out->elements = data + header_size;
+    out->elements_length = length - header_size;
+    return arrow::Status::OK();
+}
+
+arrow::Status append_array_elements(const array_header& header, const std::string& name, column_decoder* element)
+{
+    const char* data = header.elements;
+    int32_t const count = header.count;
+    int32_t const width = element->fixed_width();
+    if (!header.has_nulls && width >= 0 && static_cast<int64_t>(count) * (4 + width) == header.elements_length) {
+        // all length words must say `width`, checked without branching per element
+        bool mismatch = false;
+        for (int32_t i = 0; i < count; ++i) {
+            mismatch |= unpack_int32(data + i * (4 + width)) != width;
+        }
+        if (!mismatch) {
+            return element->append_strided(data + 4, 4 + width, count);
+        }
+    }
+    const char* const end = data + header.elements_length;
+    for (int32_t i = 0; i < count; ++i) {
+        if (end - data < 4) {
+            return corrupt_array(name);
+        }
+        int32_t const element_length = unpack_int32(data);
+        data += 4;
+        if (element_length == -1) {
+            ARROW_RETURN_NOT_OK(element->append_null());
+            continue;
+        }
+        if (element_length < 0 || end - data < element_length) {
+            return corrupt_array(name);
+        }
+        ARROW_RETURN_NOT_OK(element->append(data, element_length));
+        data += element_length;
+    }
+    return arrow::Status::OK();
+}
+
+fixed_size_list_decoder::fixed_size_list_decoder(std::string name, bool pgvector, uint32_t element_oid,
+                                                 std::vector<int32_t> shape, std::unique_ptr<column_decoder> element,
+                                                 arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    pgvector_(pgvector),
+    element_oid_(element_oid),
+    shape_(std::move(shape)),
+    size_(0),
+    element_(std::move(element)),
+    validity_(pool)
+{
+}
+
+arrow::Status fixed_size_list_decoder::init()
+{
+    int64_t size = shape_.empty() ? 0 : 1;
+    for (int32_t dim : shape_) {
+        size *= dim;
+    }
+    if (size > std::numeric_limits<int32_t>::max()) {
+        return arrow::Status::Invalid("shape ", shape_string(shape_.data(), shape_.size()), " of column '", name_,
+                                      "' is too large");
+    }
+    size_ = static_cast<int32_t>(size);
+    storage_type_ = arrow::fixed_size_list(element_->type(), size_);
+    if (shape_.size() > 1) {
+        ARROW_ASSIGN_OR_RAISE(type_, arrow::extension::FixedShapeTensorType::Make(
+                                         element_->type(), std::vector<int64_t>(shape_.begin(), shape_.end())));
+    } else {
+        type_ = storage_type_;
+    }
+    return arrow::Status::OK();
+}
+
+int32_t fixed_size_list_decoder::fixed_width() const
+{
+    return pgvector_ && !shape_.empty() ? VECTOR_HEADER_SIZE + 4 * size_ : -1;
+}
+
+arrow::Status fixed_size_list_decoder::check_shape(const int32_t* dims, int32_t ndim)
+{
+    if (shape_.empty()) {
+        if (ndim == 0) {
+            return arrow::Status::Invalid("cannot take the shape of column '", name_, "' from an empty array");
+        }
+        shape_.assign(dims, dims + ndim);
+        ARROW_RETURN_NOT_OK(init());
+        // the rows so far are all NULL
+        for (int64_t i = 0; i < validity_.length() * size_; ++i) {
+            ARROW_RETURN_NOT_OK(element_->append_null());
+        }
+        return arrow::Status::OK();
+    }
+    if (static_cast<std::size_t>(ndim) != shape_.size() || !std::equal(shape_.begin(), shape_.end(), dims)) {
+        return arrow::Status::Invalid("value of shape ", shape_string(dims, ndim), " in column '", name_,
+                                      "' of shape ", shape_string(shape_.data(), shape_.size()));
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status fixed_size_list_decoder::append(const char* data, int32_t length)
+{
+    if (pgvector_) {
+        if (length < VECTOR_HEADER_SIZE) {
+            return corrupt_array(name_);
+        }
+        int32_t const dim = static_cast<uint16_t>(unpack_int16(data));
+        ARROW_RETURN_NOT_OK(check_shape(&dim, 1));
+        if (length != VECTOR_HEADER_SIZE + 4 * dim) {
+            return corrupt_array(name_);
+        }
+        // the floats are contiguous, which append_strided() copies and
+        // swaps in bulk rather than gathering them
+        ARROW_RETURN_NOT_OK(element_->append_strided(data + VECTOR_HEADER_SIZE, 4, dim));
+    } else {
+        array_header header;
+        ARROW_RETURN_NOT_OK(parse_array_header(data, length, name_, &header));
+        if (element_oid_ != 0 && header.element_oid != element_oid_) {
+            return arrow::Status::Invalid("array of element type oid ", header.element_oid, " in column '", name_,
+                                          "', expected ", element_oid_);
+        }
+        ARROW_RETURN_NOT_OK(check_shape(header.dims, header.ndim));
+        ARROW_RETURN_NOT_OK(append_array_elements(header, name_, element_.get()));
+    }
+    return validity_.append_valid();
+}
+
+arrow::Status fixed_size_list_decoder::append_null()
+{
+    for (int32_t i = 0; i < size_; ++i) {
+        ARROW_RETURN_NOT_OK(element_->append_null());
+    }
+    return validity_.append_null();
+}
+
+arrow::Status fixed_size_list_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return element_->reserve(n * size_);
+}
+
+arrow::Status fixed_size_list_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Array> values;
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(element_->finish(&values));
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    auto array = arrow::ArrayData::Make(storage_type_, length, {validity}, null_count);
+    array->child_data.push_back(values->data());
+    *out = arrow::MakeArray(std::move(array));
+    if (type_->id() == arrow::Type::EXTENSION) {
+        *out = arrow::ExtensionType::WrapArray(type_, *out);
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status make_array_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                 std::unique_ptr<column_decoder>* out)
+{
+    if (spec.children.size() != 1) {
+        return arrow::Status::Invalid("array column '", spec.name, "' needs one element type, got ",
+                                      spec.children.size());
+    }
+    column_spec const& element_spec = spec.children.front();
+    std::unique_ptr<column_decoder> element;
+    ARROW_RETURN_NOT_OK(make_column_decoder(element_spec, types, pool, &element));
+    // enum elements have no fixed oid to check against
+    uint32_t const element_oid = element_spec.enum_labels.empty() ? element_spec.oid : 0;
+
+    bool const pgvector = spec.kind == type_kind::vector;
+    if (pgvector || !spec.dims.empty() || (types.fixed_size_arrays && element->fixed_width() >= 0)) {
+        if (element->fixed_width() < 0) {
+            return arrow::Status::NotImplemented("elements of fixed size array column '", spec.name,
+                                                 "' must have a fixed width");
+        }
+        std::vector<int32_t> shape = spec.dims;
+        if (pgvector && spec.typmod > 0) {
+            shape = {spec.typmod};
+        }
+        std::unique_ptr<fixed_size_list_decoder> decoder(new fixed_size_list_decoder(
+            spec.name, pgvector, element_oid, std::move(shape), std::move(element), pool));
+        ARROW_RETURN_NOT_OK(decoder->init());
+        *out = std::move(decoder);
+    } else if (types.large_lists) {
+        out->reset(new list_decoder<arrow::LargeListType>(spec.name, element_oid, std::move(element), pool));
+    } else {
+        out->reset(new list_decoder<arrow::ListType>(spec.name, element_oid, std::move(element), pool));
+    }
+    return arrow::Status::OK();
+}
+
+}
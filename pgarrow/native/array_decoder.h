@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of arrays in the send format (see array_send in PG's
+ * utils/adt/arrayfuncs.c): int32 ndim, int32 flags (1 if any element is
+ * NULL), uint32 element type oid, then an int32 size and lower bound per
+ * dimension, then the elements in row-major order, each as a length word
+ * (-1 for NULL) followed by the element's own send format.
+ */
+constexpr int32_t ARRAY_HEADER_SIZE = 12;
+constexpr int32_t ARRAY_DIM_SIZE = 8;
+// most dimensions an array can have (MAXDIM in PG's utils/array.h)
+constexpr int32_t ARRAY_MAX_DIMS = 6;
+
+/**
+ * @brief Header of an array field, and where its elements are
+ */
+struct array_header {
+    int32_t ndim;
+    bool has_nulls;
+    uint32_t element_oid;
+    int32_t dims[ARRAY_MAX_DIMS];
+    /// number of elements, the product of the dimensions
+    int32_t count;
+    const char* elements;
+    int32_t elements_length;
+};
+
+/**
+ * @brief Parse the header of the array field of `length` bytes at `data`
+ *        of column `name`
+ */
+arrow::Status parse_array_header(const char* data, int32_t length, const std::string& name, array_header* out);
+
+/**
+ * @brief Append the elements of an array to the decoder of its element
+ *        type, in one append_strided() call if they are of a fixed width
+ *        and none is NULL
+ */
+arrow::Status append_array_elements(const array_header& header, const std::string& name, column_decoder* element);
+
+/**
+ * @brief Decoder for 1-D array columns into list (int32 offsets) or
+ *        large_list (int64 offsets) arrays.
+ *
+ * Elements are appended straight into the decoder of the element type,
+ * which builds the child array, while the offsets and validity of the list
+ * are written in the same pass. Arrays of a fixed width type without NULL
+ * elements are laid out at a constant stride, so they are handed to the
+ * element decoder in one append_strided() call and swapped in bulk.
+ * Empty (zero dimension) arrays become empty lists.
+ */
+template <typename List>
+class list_decoder : public column_decoder {
+  public:
+    using offset_type = typename List::offset_type;
+
+    list_decoder(std::string name, uint32_t element_oid, std::unique_ptr<column_decoder> element,
+                 arrow::MemoryPool* pool) :
+        name_(std::move(name)),
+        element_oid_(element_oid),
+        element_(std::move(element)),
+        offsets_(pool),
+        validity_(pool),
+        elements_(0)
+    {
+    }
+
+    std::shared_ptr<arrow::DataType> type() const override
+    {
+        return std::make_shared<List>(element_->type());
+    }
+
+    arrow::Status append(const char* data, int32_t length) override
+    {
+        array_header header;
+        ARROW_RETURN_NOT_OK(parse_array_header(data, length, name_, &header));
+        if (header.ndim > 1) {
+            return arrow::Status::NotImplemented("column '", name_, "' holds an array of ", header.ndim,
+                                                 " dimensions, declare its shape (e.g. float4[3][4]) or use "
+                                                 "fixed_size_arrays");
+        }
+        if (element_oid_ != 0 && header.element_oid != element_oid_) {
+            return arrow::Status::Invalid("array of element type oid ", header.element_oid, " in column '", name_,
+                                          "', expected ", element_oid_);
+        }
+        if (elements_ + header.count > std::numeric_limits<offset_type>::max()) {
+            return arrow::Status::CapacityError("more than 2^31 array elements in one batch of column '", name_,
+                                                "', use large_lists or smaller batches");
+        }
+        ARROW_RETURN_NOT_OK(append_array_elements(header, name_, element_.get()));
+        ARROW_RETURN_NOT_OK(append_offset(header.count));
+        return validity_.append_valid();
+    }
+
+    arrow::Status append_null() override
+    {
+        ARROW_RETURN_NOT_OK(append_offset(0));
+        return validity_.append_null();
+    }
+
+    arrow::Status reserve(int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(validity_.reserve(n));
+        return offsets_.Reserve(n + 1);
+    }
+
+    void set_source(std::shared_ptr<arrow::Buffer> source) override { element_->set_source(std::move(source)); }
+
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override
+    {
+        if (offsets_.length() == 0) {
+            ARROW_RETURN_NOT_OK(offsets_.Append(0));
+        }
+        int64_t const length = offsets_.length() - 1;
+        int64_t const null_count = validity_.null_count();
+        std::shared_ptr<arrow::Array> values;
+        std::shared_ptr<arrow::Buffer> validity;
+        std::shared_ptr<arrow::Buffer> offsets;
+        ARROW_RETURN_NOT_OK(element_->finish(&values));
+        ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+        ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+        auto array = arrow::ArrayData::Make(std::make_shared<List>(values->type()), length, {validity, offsets},
+                                            null_count);
+        array->child_data.push_back(values->data());
+        *out = arrow::MakeArray(std::move(array));
+        elements_ = 0;
+        return arrow::Status::OK();
+    }
+
+  private:
+    arrow::Status append_offset(int32_t count)
+    {
+        if (offsets_.length() == 0) {
+            ARROW_RETURN_NOT_OK(offsets_.Append(0));
+        }
+        elements_ += count;
+        return offsets_.Append(static_cast<offset_type>(elements_));
+    }
+
+    std::string name_;
+    uint32_t element_oid_;
+    std::unique_ptr<column_decoder> element_;
+    arrow::TypedBufferBuilder<offset_type> offsets_;
+    validity_bitmap validity_;
+    // elements in the current batch, the next offset
+    int64_t elements_;
+};
+
+/*
+ * Layout of pgvector's vector in the send format (see vector_send in
+ * pgvector's src/vector.c): uint16 dim, uint16 unused, then dim float4.
+ */
+constexpr int32_t VECTOR_HEADER_SIZE = 4;
+
+/**
+ * @brief Decoder for array columns of a constant shape, and pgvector
+ *        columns, into fixed_size_list arrays, or fixed_shape_tensor arrays
+ *        for shapes of more than one dimension.
+ *
+ * The shape is declared (float4[768], float4[3][4], vector(768)) or taken
+ * from the first non-NULL value; values of any other shape fail the decode.
+ * Until then the type has a size of 0, which batches of NULLs keep and
+ * copy_decoder::make_table replaces with the type the other batches found.
+ * No offsets are written. The elements go into the decoder of the element
+ * type, which must have a fixed width, in one append_strided() call per
+ * value: over the length words of arrays without NULL elements, over the
+ * contiguous payload of vectors. A NULL value takes as many NULL elements.
+ */
+class fixed_size_list_decoder : public column_decoder {
+  public:
+    fixed_size_list_decoder(std::string name, bool pgvector, uint32_t element_oid, std::vector<int32_t> shape,
+                            std::unique_ptr<column_decoder> element, arrow::MemoryPool* pool);
+
+    /**
+     * @brief Set the type for the shape, if known
+     */
+    arrow::Status init();
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+    int32_t fixed_width() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Check the shape of a value against the column's, adopting it
+     *        if the column has none yet
+     */
+    arrow::Status check_shape(const int32_t* dims, int32_t ndim);
+
+    std::string name_;
+    bool pgvector_;
+    uint32_t element_oid_;
+    std::vector<int32_t> shape_;
+    // elements per value, the product of the shape
+    int32_t size_;
+    std::unique_ptr<column_decoder> element_;
+    std::shared_ptr<arrow::DataType> type_;
+    std::shared_ptr<arrow::DataType> storage_type_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for an array or pgvector column, whose element
+ *        type is described by the spec's only child
+ */
+arrow::Status make_array_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                 std::unique_ptr<column_decoder>* out);
+
+}
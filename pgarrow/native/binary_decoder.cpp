@@ -0,0 +1,182 @@
+#include "binary_decoder.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <arrow/util/binary_view_util.h>
+
+namespace pgarrow {
+
+template <typename Offset>
+binary_decoder<Offset>::binary_decoder(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool) :
+    type_(std::move(type)),
+    offsets_(pool),
+    data_(pool),
+    validity_(pool)
+{
+}
+
+template <typename Offset>
+arrow::Status binary_decoder<Offset>::append_null()
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<Offset>(data_.length())));
+    return validity_.append_null();
+}
+
+template <typename Offset>
+arrow::Status binary_decoder<Offset>::append_indexed(const char* data, const int64_t* tuple_offsets,
+                                                     const uint32_t* field_offsets, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(reserve(n));
+    for (int64_t i = 0; i < n; ++i) {
+        const char* field = data + tuple_offsets[i] + field_offsets[i];
+        int32_t length = unpack_int32(field);
+        if (length == -1) {
+            ARROW_RETURN_NOT_OK(append_null());
+        } else {
+            ARROW_RETURN_NOT_OK(append_value(field + 4, length));
+        }
+    }
+    return arrow::Status::OK();
+}
+
+template <typename Offset>
+arrow::Status binary_decoder<Offset>::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    ARROW_RETURN_NOT_OK(offsets_.Reserve(n + 1));
+    // size the data for as many bytes per value as the batch had so far
+    int64_t const values = offsets_.length() - 1;
+    if (values <= 0 || data_.length() == 0) {
+        return arrow::Status::OK();
+    }
+    double const estimate = static_cast<double>(data_.length()) / values * n;
+    double const room = static_cast<double>(std::numeric_limits<Offset>::max() - data_.length());
+    return data_.Reserve(static_cast<int64_t>(std::min(estimate, room)));
+}
+
+template <typename Offset>
+arrow::Status binary_decoder<Offset>::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    int64_t const length = offsets_.length() - 1;
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    std::shared_ptr<arrow::Buffer> offsets;
+    std::shared_ptr<arrow::Buffer> data;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(data_.Finish(&data));
+    *out = arrow::MakeArray(arrow::ArrayData::Make(type_, length, {validity, offsets, data}, null_count));
+    return arrow::Status::OK();
+}
+
+template class binary_decoder<int32_t>;
+template class binary_decoder<int64_t>;
+
+binary_view_decoder::binary_view_decoder(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool) :
+    type_(std::move(type)),
+    views_(pool),
+    validity_(pool),
+    slice_index_(-1),
+    slice_start_(nullptr),
+    copies_index_(-1),
+    copies_(pool)
+{
+}
+
+arrow::Status binary_view_decoder::append_value(const char* data, int32_t length)
+{
+    ARROW_RETURN_NOT_OK(validity_.append_valid());
+    if (length <= arrow::BinaryViewType::kInlineSize) {
+        return views_.Append(arrow::util::ToInlineBinaryView(data, length));
+    }
+
+    auto const value = reinterpret_cast<const uint8_t*>(data);
+    if (source_ == nullptr || value < source_->data() || value + length > source_->data() + source_->size()) {
+        return append_copy(data, length);
+    }
+    if (slice_index_ == -1 || value < slice_start_ ||
+        value + length - slice_start_ > std::numeric_limits<int32_t>::max()) {
+        int64_t const offset = value - source_->data();
+        buffers_.push_back(arrow::SliceBuffer(source_, offset, source_->size() - offset));
+        slice_index_ = static_cast<int32_t>(buffers_.size() - 1);
+        slice_start_ = value;
+    }
+    return views_.Append(arrow::util::ToNonInlineBinaryView(data, length, slice_index_,
+                                                            static_cast<int32_t>(value - slice_start_)));
+}
+
+arrow::Status binary_view_decoder::append_copy(const char* data, int32_t length)
+{
+    if (copies_index_ == -1 || copies_.length() + length > std::numeric_limits<int32_t>::max()) {
+        if (copies_index_ != -1) {
+            ARROW_RETURN_NOT_OK(copies_.Finish(&buffers_[copies_index_]));
+        }
+        buffers_.emplace_back();
+        copies_index_ = static_cast<int32_t>(buffers_.size() - 1);
+    }
+    auto const offset = static_cast<int32_t>(copies_.length());
+    ARROW_RETURN_NOT_OK(copies_.Append(data, length));
+    return views_.Append(arrow::util::ToNonInlineBinaryView(data, length, copies_index_, offset));
+}
+
+arrow::Status binary_view_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(validity_.append_null());
+    return views_.Append(arrow::BinaryViewType::c_type{});
+}
+
+arrow::Status binary_view_decoder::append_indexed(const char* data, const int64_t* tuple_offsets,
+                                                  const uint32_t* field_offsets, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(reserve(n));
+    for (int64_t i = 0; i < n; ++i) {
+        const char* field = data + tuple_offsets[i] + field_offsets[i];
+        int32_t length = unpack_int32(field);
+        if (length == -1) {
+            ARROW_RETURN_NOT_OK(append_null());
+        } else {
+            ARROW_RETURN_NOT_OK(append_value(field + 4, length));
+        }
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status binary_view_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return views_.Reserve(n);
+}
+
+void binary_view_decoder::set_source(std::shared_ptr<arrow::Buffer> source)
+{
+    source_ = std::move(source);
+    slice_index_ = -1;
+}
+
+arrow::Status binary_view_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (copies_index_ != -1) {
+        ARROW_RETURN_NOT_OK(copies_.Finish(&buffers_[copies_index_]));
+    }
+    int64_t const length = views_.length();
+    int64_t const null_count = validity_.null_count();
+    std::vector<std::shared_ptr<arrow::Buffer>> buffers(2);
+    ARROW_RETURN_NOT_OK(validity_.finish(&buffers[0]));
+    ARROW_RETURN_NOT_OK(views_.Finish(&buffers[1]));
+    buffers.insert(buffers.end(), buffers_.begin(), buffers_.end());
+    *out = arrow::MakeArray(arrow::ArrayData::Make(type_, length, std::move(buffers), null_count));
+
+    buffers_.clear();
+    slice_index_ = -1;
+    copies_index_ = -1;
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/**
+ * @brief Decoder for text-like and bytea columns into utf8/binary arrays
+ *        (int32_t offsets) or large_utf8/large_binary arrays (int64_t
+ *        offsets), copying every value into the data buffer of the batch.
+ *
+ * The send format of these types is the raw bytes of the value, so decoding
+ * is a copy; text is not validated as UTF-8 (PG has already done so for
+ * UTF-8 databases). reserve() sizes the data buffer by the average length
+ * of the values of the batch so far, once there are any.
+ */
+template <typename Offset>
+class binary_decoder : public column_decoder {
+  public:
+    binary_decoder(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+
+    arrow::Status append(const char* data, int32_t length) override { return append_value(data, length); }
+    arrow::Status append_null() override;
+    arrow::Status append_indexed(const char* data, const int64_t* tuple_offsets,
+                                 const uint32_t* field_offsets, int64_t n) override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    arrow::Status append_value(const char* data, int32_t length)
+    {
+        if (offsets_.length() == 0) {
+            ARROW_RETURN_NOT_OK(offsets_.Append(0));
+        }
+        if (data_.length() + length > std::numeric_limits<Offset>::max()) {
+            return arrow::Status::CapacityError("more than 2 GB of ", type_->ToString(),
+                                                " data in one batch, use string_view, large_strings or smaller "
+                                                "batches");
+        }
+        ARROW_RETURN_NOT_OK(data_.Append(data, length));
+        ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<Offset>(data_.length())));
+        return validity_.append_valid();
+    }
+
+    std::shared_ptr<arrow::DataType> type_;
+    arrow::TypedBufferBuilder<Offset> offsets_;
+    arrow::BufferBuilder data_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Decoder for text-like and bytea columns into string_view/binary_view
+ *        arrays whose views point into the input buffer.
+ *
+ * Values of up to 12 bytes are stored inline in their view. Longer values
+ * inside the current source buffer (see set_source()) are referenced through
+ * a slice of it, so the batch keeps the input alive and nothing is copied; a
+ * new slice is started whenever an offset would no longer fit in 32 bits.
+ * Values from outside the source are copied into a buffer of the batch.
+ */
+class binary_view_decoder : public column_decoder {
+  public:
+    binary_view_decoder(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+
+    arrow::Status append(const char* data, int32_t length) override { return append_value(data, length); }
+    arrow::Status append_null() override;
+    arrow::Status append_indexed(const char* data, const int64_t* tuple_offsets,
+                                 const uint32_t* field_offsets, int64_t n) override;
+    arrow::Status reserve(int64_t n) override;
+    void set_source(std::shared_ptr<arrow::Buffer> source) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    arrow::Status append_value(const char* data, int32_t length);
+
+    /**
+     * @brief Copy a value that is not in the source into the batch's own buffer
+     */
+    arrow::Status append_copy(const char* data, int32_t length);
+
+    std::shared_ptr<arrow::DataType> type_;
+    arrow::TypedBufferBuilder<arrow::BinaryViewType::c_type> views_;
+    validity_bitmap validity_;
+    std::shared_ptr<arrow::Buffer> source_;
+    // data buffers referenced by the views of the current batch
+    std::vector<std::shared_ptr<arrow::Buffer>> buffers_;
+    // slice of the source the current views point into, if any
+    int32_t slice_index_;
+    const uint8_t* slice_start_;
+    // buffer of copied values, allocated on the first one
+    int32_t copies_index_;
+    arrow::BufferBuilder copies_;
+};
+
+}
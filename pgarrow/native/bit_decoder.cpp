@@ -0,0 +1,223 @@
+#include "bit_decoder.h"
+
+#include <limits>
+
+namespace pgarrow {
+
+bool_decoder::bool_decoder(arrow::MemoryPool* pool) :
+    words_(pool),
+    word_(0),
+    length_(0),
+    validity_(pool)
+{
+}
+
+arrow::Status bool_decoder::append(const char* data, int32_t length)
+{
+    if (length != 1) {
+        return arrow::Status::Invalid("expected field of 1 byte for bool, got ", length);
+    }
+    ARROW_RETURN_NOT_OK(words_.Reserve(1));
+    append_bit(data[0] != 0);
+    return validity_.append_valid();
+}
+
+arrow::Status bool_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(words_.Reserve(1));
+    append_bit(false);
+    return validity_.append_null();
+}
+
+arrow::Status bool_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return words_.Reserve((n + 63) / 64);
+}
+
+arrow::Status bool_decoder::append_indexed(const char* data, const int64_t* tuple_offsets,
+                                           const uint32_t* field_offsets, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(words_.Reserve(n / 64 + 1));
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    for (int64_t i = 0; i < n; ++i) {
+        const char* field = data + tuple_offsets[i] + field_offsets[i];
+        int32_t const length = unpack_int32(field);
+        if (length == 1) {
+            append_bit(field[4] != 0);
+            ARROW_RETURN_NOT_OK(validity_.append_valid());
+        } else if (length == -1) {
+            append_bit(false);
+            ARROW_RETURN_NOT_OK(validity_.append_null());
+        } else {
+            // let append() report the bad length
+            return append(field + 4, length);
+        }
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status bool_decoder::append_strided(const char* data, int64_t stride, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(words_.Reserve(n / 64 + 1));
+    int64_t i = 0;
+    for (; i < n && (length_ & 63) != 0; ++i) {
+        append_bit(data[i * stride] != 0);
+    }
+    for (; i + 64 <= n; i += 64) {
+        uint64_t word = 0;
+        for (int64_t bit = 0; bit < 64; ++bit) {
+            word |= uint64_t(data[(i + bit) * stride] != 0) << bit;
+        }
+        words_.UnsafeAppend(word);
+        length_ += 64;
+    }
+    for (; i < n; ++i) {
+        append_bit(data[i * stride] != 0);
+    }
+    return validity_.append_valid(n);
+}
+
+arrow::Status bool_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if ((length_ & 63) != 0) {
+        ARROW_RETURN_NOT_OK(words_.Append(word_));
+    }
+    int64_t const length = length_;
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    std::shared_ptr<arrow::Buffer> values;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    words_to_bitmap(words_.mutable_data(), words_.length());
+    ARROW_RETURN_NOT_OK(words_.Finish(&values));
+    word_ = 0;
+    length_ = 0;
+    *out = arrow::MakeArray(arrow::ArrayData::Make(arrow::boolean(), length, {validity, values}, null_count));
+    return arrow::Status::OK();
+}
+
+varbit_decoder::varbit_decoder(std::string name, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    offsets_(pool),
+    data_(pool),
+    lengths_(pool),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> varbit_decoder::type() const
+{
+    return arrow::struct_(
+        {arrow::field("bits", arrow::binary(), false), arrow::field("length", arrow::int32(), false)});
+}
+
+arrow::Status varbit_decoder::append(const char* data, int32_t length)
+{
+    int32_t const bits = length < BIT_HEADER_SIZE ? -1 : unpack_int32(data);
+    if (bits < 0 || length - BIT_HEADER_SIZE != (int64_t(bits) + 7) / 8) {
+        return arrow::Status::Invalid("corrupt bit string field in column '", name_, "'");
+    }
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    if (data_.length() + length - BIT_HEADER_SIZE > std::numeric_limits<int32_t>::max()) {
+        return arrow::Status::CapacityError("more than 2 GB of bit strings in one batch of column '", name_,
+                                            "', use smaller batches");
+    }
+    ARROW_RETURN_NOT_OK(data_.Append(data + BIT_HEADER_SIZE, length - BIT_HEADER_SIZE));
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+    ARROW_RETURN_NOT_OK(lengths_.Append(bits));
+    return validity_.append_valid();
+}
+
+arrow::Status varbit_decoder::append_null()
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+    ARROW_RETURN_NOT_OK(lengths_.Append(0));
+    return validity_.append_null();
+}
+
+arrow::Status varbit_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    ARROW_RETURN_NOT_OK(lengths_.Reserve(n));
+    return offsets_.Reserve(n + 1);
+}
+
+arrow::Status varbit_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity, offsets, data, lengths;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(data_.Finish(&data));
+    ARROW_RETURN_NOT_OK(lengths_.Finish(&lengths));
+    auto array = arrow::ArrayData::Make(type(), length, {validity}, null_count);
+    array->child_data.push_back(arrow::ArrayData::Make(arrow::binary(), length, {nullptr, offsets, data}, 0));
+    array->child_data.push_back(arrow::ArrayData::Make(arrow::int32(), length, {nullptr, lengths}, 0));
+    *out = arrow::MakeArray(std::move(array));
+    return arrow::Status::OK();
+}
+
+bit_decoder::bit_decoder(std::string name, int32_t bits, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    bits_(bits),
+    bytes_((bits + 7) / 8),
+    values_(pool),
+    validity_(pool)
+{
+}
+
+arrow::Status bit_decoder::append(const char* data, int32_t length)
+{
+    if (length != fixed_width() || unpack_int32(data) != bits_) {
+        int32_t const bits = length < BIT_HEADER_SIZE ? -1 : unpack_int32(data);
+        return arrow::Status::Invalid("bit string of ", bits, " bits in column '", name_, "' of type bit(", bits_,
+                                      ")");
+    }
+    ARROW_RETURN_NOT_OK(values_.Append(data + BIT_HEADER_SIZE, bytes_));
+    return validity_.append_valid();
+}
+
+arrow::Status bit_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(values_.Append(bytes_, 0));
+    return validity_.append_null();
+}
+
+arrow::Status bit_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return values_.Reserve(n * bytes_);
+}
+
+arrow::Status bit_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    std::shared_ptr<arrow::Buffer> values;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(values_.Finish(&values));
+    *out = arrow::MakeArray(arrow::ArrayData::Make(type(), length, {validity, values}, null_count));
+    return arrow::Status::OK();
+}
+
+arrow::Status make_bit_decoder(const column_spec& spec, arrow::MemoryPool* pool, std::unique_ptr<column_decoder>* out)
+{
+    if (spec.oid == BITOID && spec.typmod > 0) {
+        out->reset(new bit_decoder(spec.name, spec.typmod, pool));
+    } else {
+        out->reset(new varbit_decoder(spec.name, pool));
+    }
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/**
+ * @brief Decoder for bool columns into boolean arrays.
+ *
+ * PG sends a bool as one byte; the values are packed straight into the
+ * bits of a 64-bit word, which is appended to the values buffer once it
+ * holds 64 rows, so no byte per row is ever stored. Runs at a constant
+ * stride (arrays of bool) fill whole words at a time.
+ */
+class bool_decoder : public column_decoder {
+  public:
+    explicit bool_decoder(arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return arrow::boolean(); }
+    int32_t fixed_width() const override { return 1; }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status append_indexed(const char* data, const int64_t* tuple_offsets,
+                                 const uint32_t* field_offsets, int64_t n) override;
+    arrow::Status append_strided(const char* data, int64_t stride, int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Add one bit to the current word, appending the word once full;
+     *        room for it must have been reserved
+     */
+    void append_bit(bool value)
+    {
+        word_ |= uint64_t(value) << (length_ & 63);
+        if ((++length_ & 63) == 0) {
+            words_.UnsafeAppend(word_);
+            word_ = 0;
+        }
+    }
+
+    arrow::TypedBufferBuilder<uint64_t> words_;
+    // bits of the rows since the last full word
+    uint64_t word_;
+    int64_t length_;
+    validity_bitmap validity_;
+};
+
+/*
+ * Layout of bit and varbit in the send format (see bit_send in PG's
+ * utils/adt/varbit.c): int32 number of bits, then the bits packed into
+ * bytes, the first bit in the most significant bit of the first byte, the
+ * unused bits of the last byte zero.
+ */
+constexpr int32_t BIT_HEADER_SIZE = 4;
+
+/**
+ * @brief Decoder for varbit columns, and bit columns of unknown length,
+ *        into struct<bits: binary, length: int32> arrays, holding the bytes
+ *        as sent and the number of bits
+ */
+class varbit_decoder : public column_decoder {
+  public:
+    varbit_decoder(std::string name, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    std::string name_;
+    arrow::TypedBufferBuilder<int32_t> offsets_;
+    arrow::BufferBuilder data_;
+    arrow::TypedBufferBuilder<int32_t> lengths_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Decoder for bit(n) columns into fixed_size_binary((n + 7) / 8)
+ *        arrays of the bytes as sent; values of another length fail the
+ *        decode
+ */
+class bit_decoder : public column_decoder {
+  public:
+    bit_decoder(std::string name, int32_t bits, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return arrow::fixed_size_binary(bytes_); }
+    int32_t fixed_width() const override { return BIT_HEADER_SIZE + bytes_; }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    std::string name_;
+    int32_t bits_;
+    int32_t bytes_;
+    arrow::BufferBuilder values_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a bit or varbit column, of fixed size for
+ *        bit(n) (typmod n)
+ */
+arrow::Status make_bit_decoder(const column_spec& spec, arrow::MemoryPool* pool,
+                               std::unique_ptr<column_decoder>* out);
+
+}
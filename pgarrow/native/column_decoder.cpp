@@ -0,0 +1,193 @@
+#include "column_decoder.h"
+
+#include "address_decoder.h"
+#include "array_decoder.h"
+#include "binary_decoder.h"
+#include "bit_decoder.h"
+#include "dictionary_decoder.h"
+#include "geometry_decoder.h"
+#include "hstore_decoder.h"
+#include "json_decoder.h"
+#include "numeric_decoder.h"
+#include "range_decoder.h"
+#include "struct_decoder.h"
+#include "temporal_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+template <typename Value>
+std::unique_ptr<column_decoder> make_fixed_width(std::shared_ptr<arrow::DataType> type,
+                                                 arrow::MemoryPool* pool)
+{
+    return std::unique_ptr<column_decoder>(new fixed_width_decoder<Value>(type, pool));
+}
+
+std::unique_ptr<column_decoder> make_binary(std::shared_ptr<arrow::DataType> type, const type_options& types,
+                                            arrow::MemoryPool* pool)
+{
+    if (types.string_view) {
+        auto view_type = type->id() == arrow::Type::STRING ? arrow::utf8_view() : arrow::binary_view();
+        return std::unique_ptr<column_decoder>(new binary_view_decoder(std::move(view_type), pool));
+    }
+    if (types.large_strings) {
+        auto large_type = type->id() == arrow::Type::STRING ? arrow::large_utf8() : arrow::large_binary();
+        return std::unique_ptr<column_decoder>(new binary_decoder<int64_t>(std::move(large_type), pool));
+    }
+    return std::unique_ptr<column_decoder>(new binary_decoder<int32_t>(std::move(type), pool));
+}
+
+std::unique_ptr<column_decoder> make_text(const type_options& types, arrow::MemoryPool* pool)
+{
+    auto plain = make_binary(arrow::utf8(), types, pool);
+    if (types.strings_as_dictionary) {
+        return std::unique_ptr<column_decoder>(
+            new dictionary_decoder(std::move(plain), types.dictionary_max_size, pool));
+    }
+    return plain;
+}
+
+}
+
+arrow::Status column_decoder::append_indexed(const char* data, const int64_t* tuple_offsets,
+                                             const uint32_t* field_offsets, int64_t n)
+{
+    for (int64_t i = 0; i < n; ++i) {
+        const char* field = data + tuple_offsets[i] + field_offsets[i];
+        int32_t length = unpack_int32(field);
+        if (length == -1) {
+            ARROW_RETURN_NOT_OK(append_null());
+        } else {
+            ARROW_RETURN_NOT_OK(append(field + 4, length));
+        }
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status column_decoder::append_strided(const char* data, int64_t stride, int64_t n)
+{
+    int32_t const width = fixed_width();
+    for (int64_t i = 0; i < n; ++i) {
+        ARROW_RETURN_NOT_OK(append(data + i * stride, width));
+    }
+    return arrow::Status::OK();
+}
+
+std::shared_ptr<arrow::DataType> plain_text_type(const type_options& types)
+{
+    if (types.string_view) {
+        return arrow::utf8_view();
+    }
+    return types.large_strings ? arrow::large_utf8() : arrow::utf8();
+}
+
+arrow::Status make_column_decoder(const column_spec& spec, const type_options& types,
+                                  arrow::MemoryPool* pool, std::unique_ptr<column_decoder>* out)
+{
+    switch (spec.kind) {
+        case type_kind::array:
+        case type_kind::vector:
+            return make_array_decoder(spec, types, pool, out);
+        case type_kind::composite:
+            return make_struct_decoder(spec, types, pool, out);
+        case type_kind::range:
+            return make_range_decoder(spec, types, pool, out);
+        case type_kind::hstore:
+            out->reset(new hstore_decoder(spec.name, pool));
+            return arrow::Status::OK();
+        case type_kind::postgis:
+            return make_postgis_decoder(spec, pool, out);
+        case type_kind::base:
+            break;
+    }
+    if (!spec.enum_labels.empty()) {
+        if (spec.enum_labels.size() <= static_cast<std::size_t>(std::numeric_limits<int16_t>::max())) {
+            return enum_decoder<arrow::Int16Type>::make(spec.name, spec.enum_labels, pool, out);
+        }
+        return enum_decoder<arrow::Int32Type>::make(spec.name, spec.enum_labels, pool, out);
+    }
+
+    switch (spec.oid) {
+        case BOOLOID:
+            out->reset(new bool_decoder(pool));
+            break;
+        case INT2OID:
+            *out = make_fixed_width<pg_int2>(arrow::int16(), pool);
+            break;
+        case INT4OID:
+            *out = make_fixed_width<pg_int4>(arrow::int32(), pool);
+            break;
+        case INT8OID:
+            *out = make_fixed_width<pg_int8>(arrow::int64(), pool);
+            break;
+        case FLOAT4OID:
+            *out = make_fixed_width<pg_float4>(arrow::float32(), pool);
+            break;
+        case FLOAT8OID:
+            *out = make_fixed_width<pg_float8>(arrow::float64(), pool);
+            break;
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID:
+        case DATEOID:
+        case TIMEOID:
+        case INTERVALOID:
+            return make_temporal_decoder(spec, types, pool, out);
+        case TEXTOID:
+        case VARCHAROID:
+        case BPCHAROID:
+        case NAMEOID:
+            *out = make_text(types, pool);
+            break;
+        case JSONOID:
+        case JSONBOID:
+            if (spec.json_struct) {
+                out->reset(new json_struct_decoder(spec.name, spec.oid == JSONBOID, spec.json_type, pool));
+                break;
+            }
+            if (spec.oid == JSONBOID) {
+                out->reset(new jsonb_decoder(spec.name, make_binary(arrow::utf8(), types, pool)));
+            } else {
+                *out = make_binary(arrow::utf8(), types, pool);
+            }
+            break;
+        case BYTEAOID:
+            *out = make_binary(arrow::binary(), types, pool);
+            break;
+        case BITOID:
+        case VARBITOID:
+            return make_bit_decoder(spec, pool, out);
+        case NUMERICOID:
+            return make_numeric_decoder(spec, types, pool, out);
+        case UUIDOID:
+            *out = make_fixed_width<pg_bytes<16>>(arrow::fixed_size_binary(16), pool);
+            break;
+        case MACADDROID:
+            *out = make_fixed_width<pg_bytes<6>>(arrow::fixed_size_binary(6), pool);
+            break;
+        case MACADDR8OID:
+            *out = make_fixed_width<pg_bytes<8>>(arrow::fixed_size_binary(8), pool);
+            break;
+        case POINTOID:
+        case LSEGOID:
+        case PATHOID:
+        case BOXOID:
+        case POLYGONOID:
+        case LINEOID:
+        case CIRCLEOID:
+            return make_geometry_decoder(spec, pool, out);
+        case INETOID:
+        case CIDROID:
+            out->reset(new inet_decoder(spec.name, pool));
+            break;
+        case TIDOID:
+            out->reset(new tid_decoder(pool));
+            break;
+        default:
+            return arrow::Status::NotImplemented("no native decoder for column '", spec.name,
+                                                 "' of type oid ", spec.oid);
+    }
+    return arrow::Status::OK();
+}
+
+}
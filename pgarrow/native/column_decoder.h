@@ -0,0 +1,421 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "../hton.h"
+#include "pg_types.h"
+#include "validity_bitmap.h"
+
+namespace pgarrow {
+
+/**
+ * @brief How the values of a column are built from other types
+ */
+enum class type_kind {
+    /// values of the type `oid` itself
+    base,
+    /// arrays of the element type described by the only child
+    array,
+    /// pgvector vectors, whose oid depends on the installation; the only
+    /// child describes their float4 elements
+    vector,
+    /// composites and records, whose attributes are the children
+    composite,
+    /// ranges of the subtype described by the only child
+    range,
+    /// hstore key/value sets, whose oid depends on the installation
+    hstore,
+    /// PostGIS geometries and geographies, whose oids depend on the
+    /// installation too
+    postgis
+};
+
+/**
+ * @brief Description of one column of a COPY BINARY stream, as far as the
+ *        decoder needs to know it
+ */
+struct column_spec {
+    std::string name;
+    uint32_t oid;
+    int32_t typmod;
+    /// labels of an enum type in pg_enum sort order; columns with labels
+    /// are decoded as enums whatever their oid
+    std::vector<std::string> enum_labels;
+    type_kind kind = type_kind::base;
+    /// element type of arrays, attributes of composites, subtype of ranges
+    std::vector<column_spec> children;
+    /// declared shape of arrays, {3, 4} for float4[3][4]; empty for arrays
+    /// of any shape
+    std::vector<int32_t> dims;
+    /// decode json and jsonb as struct arrays of the keys of their objects
+    bool json_struct = false;
+    /// struct type of such columns; nullptr to infer it from the first batch
+    std::shared_ptr<arrow::DataType> json_type;
+};
+
+/**
+ * @brief What to do with a value the column's Arrow type cannot represent
+ */
+enum class value_policy {
+    /// fail the decode
+    error,
+    /// store NULL instead
+    null
+};
+
+/**
+ * @brief Choices of Arrow representation that apply to all columns
+ */
+struct type_options {
+    /// decode text and bytea as string_view/binary_view arrays pointing into
+    /// the input buffer (see column_decoder::set_source) instead of copying
+    bool string_view = false;
+    /// decode text and bytea as large_utf8/large_binary arrays (int64_t
+    /// offsets), for batches of more than 2 GB of them
+    bool large_strings = false;
+    /// decode text columns as dictionary<int32, utf8>, falling back to
+    /// plain strings once a batch has more distinct values than this
+    bool strings_as_dictionary = false;
+    int32_t dictionary_max_size = 1 << 16;
+    /// precision and scale of numeric columns declared without them
+    int32_t numeric_precision = 38;
+    int32_t numeric_scale = 10;
+    /// numerics with more integer digits than the precision allows
+    value_policy numeric_overflow = value_policy::error;
+    /// numeric NaN and +-Infinity
+    value_policy numeric_special = value_policy::null;
+    /// unit of timestamp and time columns: MICRO as sent, or NANO
+    arrow::TimeUnit::type time_unit = arrow::TimeUnit::MICRO;
+    /// time zone recorded on timestamptz columns, whose values are UTC
+    std::string timezone = "UTC";
+    /// +-infinity timestamps and dates become NULL instead of the sentinels
+    bool infinity_as_null = false;
+    /// stored for +-infinity timestamps, in microseconds since the Unix
+    /// epoch (saturated when scaled to NANO)
+    int64_t timestamp_infinity = std::numeric_limits<int64_t>::max();
+    int64_t timestamp_neg_infinity = std::numeric_limits<int64_t>::min();
+    /// stored for +-infinity dates, in days since the Unix epoch
+    int32_t date_infinity = std::numeric_limits<int32_t>::max();
+    int32_t date_neg_infinity = std::numeric_limits<int32_t>::min();
+    /// timestamps, times and interval time parts out of range of the unit
+    value_policy time_overflow = value_policy::error;
+    /// decode arrays as large_list (int64 offsets) rather than list
+    bool large_lists = false;
+    /// decode arrays of fixed width types as fixed_size_list (or
+    /// fixed_shape_tensor) arrays of the shape of the first value
+    bool fixed_size_arrays = false;
+};
+
+/**
+ * @brief Decodes the binary send format of one PG type into an Arrow column.
+ *        One instance is fed every field of its column in row order.
+ */
+class column_decoder {
+  public:
+    virtual ~column_decoder() = default;
+
+    /**
+     * @brief Arrow type of the arrays produced by finish()
+     */
+    virtual std::shared_ptr<arrow::DataType> type() const = 0;
+
+    /**
+     * @brief Length every non-NULL field of the column has, or -1 if it varies
+     */
+    virtual int32_t fixed_width() const { return -1; }
+
+    /**
+     * @brief Append one non-NULL field of `length` bytes
+     */
+    virtual arrow::Status append(const char* data, int32_t length) = 0;
+
+    /**
+     * @brief Append one NULL field
+     */
+    virtual arrow::Status append_null() = 0;
+
+    /**
+     * @brief Make room for about `n` more rows, so that decoding them does
+     *        not have to grow the buffers repeatedly
+     */
+    virtual arrow::Status reserve(int64_t n) { return arrow::Status::OK(); }
+
+    /**
+     * @brief Append this column's field from each of `n` indexed tuples.
+     *        Field i starts with its length word at
+     *        data + tuple_offsets[i] + field_offsets[i].
+     */
+    virtual arrow::Status append_indexed(const char* data, const int64_t* tuple_offsets,
+                                         const uint32_t* field_offsets, int64_t n);
+
+    /**
+     * @brief Append `n` non-NULL fields of fixed_width() bytes, the first
+     *        starting at `data` and each following `stride` bytes later.
+     *        Only called for columns with a fixed width.
+     */
+    virtual arrow::Status append_strided(const char* data, int64_t stride, int64_t n);
+
+    /**
+     * @brief Buffer holding the data passed to the following appends, which
+     *        columns may keep referencing instead of copying their values.
+     *        Fields outside of it (or with no source set) are copied.
+     */
+    virtual void set_source(std::shared_ptr<arrow::Buffer> source) {}
+
+    /**
+     * @brief Hand out everything appended so far and reset for the next batch
+     */
+    virtual arrow::Status finish(std::shared_ptr<arrow::Array>* out) = 0;
+};
+
+/*
+ * Wire formats of the fixed width types. Each describes the Arrow type it
+ * lands in, the width of the field on the wire, how to decode one field and
+ * how to convert a run of raw (big-endian) fields in place with the bulk
+ * kernels of hton.h.
+ */
+
+struct pg_int2 {
+    using arrow_type = arrow::Int16Type;
+    using c_type = int16_t;
+    static constexpr int32_t width = 2;
+    static c_type decode(const char* buf) { return unpack_int16(buf); }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        unpack_int16_array(reinterpret_cast<char*>(values), reinterpret_cast<const char*>(values), n);
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        unpack_int16_strided(reinterpret_cast<char*>(values), buf, stride, n);
+    }
+};
+
+struct pg_int4 {
+    using arrow_type = arrow::Int32Type;
+    using c_type = int32_t;
+    static constexpr int32_t width = 4;
+    static c_type decode(const char* buf) { return unpack_int32(buf); }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        unpack_int32_array(reinterpret_cast<char*>(values), reinterpret_cast<const char*>(values), n);
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        unpack_int32_strided(reinterpret_cast<char*>(values), buf, stride, n);
+    }
+};
+
+struct pg_int8 {
+    using arrow_type = arrow::Int64Type;
+    using c_type = int64_t;
+    static constexpr int32_t width = 8;
+    static c_type decode(const char* buf) { return unpack_int64(buf); }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        unpack_int64_array(reinterpret_cast<char*>(values), reinterpret_cast<const char*>(values), n);
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        unpack_int64_strided(reinterpret_cast<char*>(values), buf, stride, n);
+    }
+};
+
+struct pg_float4 {
+    using arrow_type = arrow::FloatType;
+    using c_type = float;
+    static constexpr int32_t width = 4;
+    static c_type decode(const char* buf) { return unpack_float(buf); }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        unpack_int32_array(reinterpret_cast<char*>(values), reinterpret_cast<const char*>(values), n);
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        unpack_int32_strided(reinterpret_cast<char*>(values), buf, stride, n);
+    }
+};
+
+struct pg_float8 {
+    using arrow_type = arrow::DoubleType;
+    using c_type = double;
+    static constexpr int32_t width = 8;
+    static c_type decode(const char* buf) { return unpack_double(buf); }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        unpack_int64_array(reinterpret_cast<char*>(values), reinterpret_cast<const char*>(values), n);
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        unpack_int64_strided(reinterpret_cast<char*>(values), buf, stride, n);
+    }
+};
+
+/**
+ * @brief Types sent as `N` raw bytes (uuid, macaddr), which are copied as
+ *        they are into fixed_size_binary(N) arrays
+ */
+template <int32_t N>
+struct pg_bytes {
+    using arrow_type = arrow::FixedSizeBinaryType;
+    using c_type = std::array<uint8_t, N>;
+    static constexpr int32_t width = N;
+    static c_type decode(const char* buf)
+    {
+        c_type value;
+        std::memcpy(value.data(), buf, N);
+        return value;
+    }
+    static void decode_bulk(c_type* values, int64_t n) {}
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        for (int64_t i = 0; i < n; ++i) {
+            std::memcpy(values + i, buf + i * stride, N);
+        }
+    }
+};
+
+/**
+ * @brief Decoder for all types whose fields always have the same width.
+ *
+ * Values are written straight into an Arrow buffer. Indexed runs of fields
+ * are first copied raw and then byte swapped in bulk, as are contiguous
+ * runs; runs at a wider stride are gathered and swapped in one pass.
+ * Subclasses can then convert each run of swapped values in place (see
+ * convert()).
+ */
+template <typename Value>
+class fixed_width_decoder : public column_decoder {
+  public:
+    using c_type = typename Value::c_type;
+
+    fixed_width_decoder(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool) :
+        type_(std::move(type)),
+        values_(pool),
+        validity_(pool)
+    {
+    }
+
+    std::shared_ptr<arrow::DataType> type() const override
+    {
+        return type_;
+    }
+
+    int32_t fixed_width() const override
+    {
+        return Value::width;
+    }
+
+    arrow::Status append(const char* data, int32_t length) override
+    {
+        if (length != Value::width) {
+            return arrow::Status::Invalid("expected field of ", Value::width,
+                                          " bytes for ", type_->ToString(),
+                                          ", got ", length);
+        }
+        ARROW_RETURN_NOT_OK(validity_.append_valid());
+        ARROW_RETURN_NOT_OK(values_.Append(Value::decode(data)));
+        return convert(values_.mutable_data() + values_.length() - 1, 1);
+    }
+
+    arrow::Status append_null() override
+    {
+        ARROW_RETURN_NOT_OK(validity_.append_null());
+        return values_.Append(c_type());
+    }
+
+    arrow::Status reserve(int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(validity_.reserve(n));
+        // exactly, where Reserve() would round up to twice the capacity
+        if (values_.length() + n <= values_.capacity()) {
+            return arrow::Status::OK();
+        }
+        return values_.Resize(values_.length() + n);
+    }
+
+    arrow::Status append_indexed(const char* data, const int64_t* tuple_offsets,
+                                 const uint32_t* field_offsets, int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(values_.Reserve(n));
+        ARROW_RETURN_NOT_OK(validity_.reserve(n));
+        c_type* out = values_.mutable_data() + values_.length();
+        for (int64_t i = 0; i < n; ++i) {
+            const char* field = data + tuple_offsets[i] + field_offsets[i];
+            int32_t length = unpack_int32(field);
+            if (length == Value::width) {
+                std::memcpy(out + i, field + 4, Value::width);
+                ARROW_RETURN_NOT_OK(validity_.append_valid());
+            } else if (length == -1) {
+                std::memset(out + i, 0, Value::width);
+                ARROW_RETURN_NOT_OK(validity_.append_null());
+            } else {
+                // let append() report the bad length
+                return append(field + 4, length);
+            }
+        }
+        Value::decode_bulk(out, n);
+        values_.UnsafeAdvance(n);
+        return convert(out, n);
+    }
+
+    arrow::Status append_strided(const char* data, int64_t stride, int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(values_.Reserve(n));
+        ARROW_RETURN_NOT_OK(validity_.append_valid(n));
+        c_type* out = values_.mutable_data() + values_.length();
+        if (stride == Value::width) {
+            // contiguous values: one copy, then the bulk swap in place
+            std::memcpy(out, data, static_cast<size_t>(n) * Value::width);
+            Value::decode_bulk(out, n);
+        } else {
+            Value::decode_strided(out, data, stride, n);
+        }
+        values_.UnsafeAdvance(n);
+        return convert(out, n);
+    }
+
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override
+    {
+        int64_t const length = values_.length();
+        int64_t const null_count = validity_.null_count();
+        std::shared_ptr<arrow::Buffer> values;
+        std::shared_ptr<arrow::Buffer> validity;
+        ARROW_RETURN_NOT_OK(values_.Finish(&values));
+        ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+        *out = arrow::MakeArray(arrow::ArrayData::Make(type_, length, {validity, values}, null_count));
+        return arrow::Status::OK();
+    }
+
+  protected:
+    /**
+     * @brief Convert the `n` values just decoded, the last `n` rows of the
+     *        column, in place. NULL rows among them hold 0.
+     */
+    virtual arrow::Status convert(c_type* values, int64_t n) { return arrow::Status::OK(); }
+
+    std::shared_ptr<arrow::DataType> type_;
+    arrow::TypedBufferBuilder<c_type> values_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a column, failing with NotImplemented for
+ *        types that have no native decoder yet
+ */
+arrow::Status make_column_decoder(const column_spec& spec, const type_options& types,
+                                  arrow::MemoryPool* pool, std::unique_ptr<column_decoder>* out);
+
+/**
+ * @brief Type of text columns decoded without a dictionary, which those
+ *        with strings_as_dictionary fall back to
+ */
+std::shared_ptr<arrow::DataType> plain_text_type(const type_options& types);
+
+}
@@ -0,0 +1,690 @@
+#include "copy_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <arrow/util/parallel.h>
+
+#include "dictionary_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+// tuples that must line up before a guessed tuple boundary is believed
+constexpr int RESYNC_TUPLES = 8;
+
+// shorter runs of fixed stride tuples are not worth spreading over threads
+constexpr int64_t PARALLEL_STRIDED_ROWS = 1 << 14;
+
+// rows a chunk decodes before its bytes per row are taken as representative
+constexpr int64_t ESTIMATE_ROWS = 1 << 10;
+
+const char COPY_SIGNATURE[] = "PGCOPY\n\377\r\n";
+// signature including its trailing NUL, flags field, header extension length
+constexpr int64_t COPY_SIGNATURE_SIZE = 11;
+constexpr int64_t COPY_HEADER_SIZE = COPY_SIGNATURE_SIZE + 4 + 4;
+// bit 16 of the flags field: each tuple carries an OID
+constexpr int32_t COPY_FLAG_OIDS = 1 << 16;
+
+}
+
+arrow::Status copy_decoder::make(const std::vector<column_spec>& columns, const decode_options& options,
+                                 arrow::MemoryPool* pool, std::unique_ptr<copy_decoder>* out)
+{
+    std::vector<std::unique_ptr<column_decoder>> decoders;
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for (auto const& spec : columns) {
+        std::unique_ptr<column_decoder> decoder;
+        ARROW_RETURN_NOT_OK(make_column_decoder(spec, options.types, pool, &decoder));
+        fields.push_back(arrow::field(spec.name, decoder->type()));
+        decoders.push_back(std::move(decoder));
+    }
+    out->reset(new copy_decoder(columns, std::move(decoders), arrow::schema(fields), options, pool));
+    return arrow::Status::OK();
+}
+
+copy_decoder::copy_decoder(std::vector<column_spec> specs, std::vector<std::unique_ptr<column_decoder>> columns,
+                           std::shared_ptr<arrow::Schema> schema, const decode_options& options,
+                           arrow::MemoryPool* pool) :
+    specs_(std::move(specs)),
+    columns_(std::move(columns)),
+    schema_(std::move(schema)),
+    options_(options),
+    pool_(pool),
+    field_data_(columns_.size()),
+    field_length_(columns_.size()),
+    tuple_stride_(2),
+    header_done_(false),
+    finished_(false),
+    num_rows_(0),
+    flushed_rows_(0)
+{
+    index_.field_offsets.resize(columns_.size());
+    for (auto const& column : columns_) {
+        int32_t width = column->fixed_width();
+        if (width < 0) {
+            tuple_stride_ = -1;
+            field_widths_.clear();
+            field_offsets_.clear();
+            break;
+        }
+        field_widths_.push_back(width);
+        field_offsets_.push_back(tuple_stride_);
+        tuple_stride_ += 4 + width;
+    }
+}
+
+arrow::Status copy_decoder::decode_header(const char* data, int64_t size, int64_t* consumed)
+{
+    *consumed = 0;
+    if (size < COPY_HEADER_SIZE) {
+        return arrow::Status::OK();
+    }
+    if (std::memcmp(data, COPY_SIGNATURE, COPY_SIGNATURE_SIZE) != 0) {
+        return arrow::Status::Invalid("not a COPY BINARY stream: bad signature");
+    }
+    int32_t flags = unpack_int32(data + COPY_SIGNATURE_SIZE);
+    if (flags & COPY_FLAG_OIDS) {
+        return arrow::Status::NotImplemented("COPY BINARY streams WITH OIDS are not supported");
+    }
+    int32_t extension_length = unpack_int32(data + COPY_SIGNATURE_SIZE + 4);
+    if (extension_length < 0) {
+        return arrow::Status::Invalid("corrupt COPY BINARY header extension length");
+    }
+    if (size - COPY_HEADER_SIZE < extension_length) {
+        return arrow::Status::OK();
+    }
+    *consumed = COPY_HEADER_SIZE + extension_length;
+    header_done_ = true;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::scan_tuple(const char* data, int64_t size, int64_t pos, int64_t* end)
+{
+    auto const n_columns = static_cast<int16_t>(columns_.size());
+    int16_t n_fields = unpack_int16(data + pos);
+    if (n_fields != n_columns) {
+        return arrow::Status::Invalid("expected tuple of ", n_columns, " fields, got ", n_fields);
+    }
+
+    // Only find the extent of the tuple here, so that a tuple cut in half
+    // by the end of the buffer is left alone until the rest arrives
+    int64_t p = pos + 2;
+    *end = -1;
+    for (int16_t i = 0; i < n_fields; ++i) {
+        if (size - p < 4) {
+            return arrow::Status::OK();
+        }
+        int32_t length = unpack_int32(data + p);
+        p += 4;
+        if (length < -1) {
+            return arrow::Status::Invalid("corrupt field length ", length);
+        }
+        field_data_[i] = data + p;
+        field_length_[i] = length;
+        if (length > 0) {
+            if (size - p < length) {
+                return arrow::Status::OK();
+            }
+            p += length;
+        }
+    }
+    *end = p;
+    return arrow::Status::OK();
+}
+
+void copy_decoder::set_source(std::shared_ptr<arrow::Buffer> source)
+{
+    for (auto& column : columns_) {
+        column->set_source(source);
+    }
+    source_ = std::move(source);
+}
+
+arrow::Status copy_decoder::reserve(int64_t n)
+{
+    for (auto& column : columns_) {
+        ARROW_RETURN_NOT_OK(column->reserve(n));
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::presize(int64_t row_limit)
+{
+    int64_t const remaining = options_.expected_rows - flushed_rows_;
+    if (num_rows_ != 0 || remaining <= 0) {
+        return arrow::Status::OK();
+    }
+    return reserve(std::min(remaining, row_limit));
+}
+
+arrow::Status copy_decoder::reserve_estimate(int64_t rows, int64_t bytes, int64_t remaining)
+{
+    if (rows <= 0 || bytes <= 0 || remaining <= 0) {
+        return arrow::Status::OK();
+    }
+    double const estimate = static_cast<double>(remaining) / bytes * rows;
+    return reserve(static_cast<int64_t>(std::min<double>(estimate, std::numeric_limits<int32_t>::max())));
+}
+
+int64_t copy_decoder::count_strided(const char* data, int64_t pos, int64_t max_rows) const
+{
+    auto const n_columns = static_cast<int16_t>(columns_.size());
+    int64_t n = 0;
+    for (; n < max_rows; ++n, pos += tuple_stride_) {
+        if (unpack_int16(data + pos) != n_columns) {
+            break;
+        }
+        std::size_t i = 0;
+        while (i != field_widths_.size() && unpack_int32(data + pos + field_offsets_[i]) == field_widths_[i]) {
+            ++i;
+        }
+        if (i != field_widths_.size()) {
+            break;
+        }
+    }
+    return n;
+}
+
+arrow::Status copy_decoder::decode_strided(const char* data, int64_t n)
+{
+    auto decode_column = [&](int i) {
+        return columns_[i]->append_strided(data + field_offsets_[i] + 4, tuple_stride_, n);
+    };
+    if (options_.use_threads && n >= PARALLEL_STRIDED_ROWS && columns_.size() > 1) {
+        ARROW_RETURN_NOT_OK(arrow::internal::ParallelFor(static_cast<int>(columns_.size()), decode_column));
+    } else {
+        for (std::size_t i = 0; i != columns_.size(); ++i) {
+            ARROW_RETURN_NOT_OK(decode_column(static_cast<int>(i)));
+        }
+    }
+    num_rows_ += n;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::decode(const char* data, int64_t size, int64_t* consumed,
+                                   int64_t row_limit)
+{
+    int64_t pos = 0;
+    *consumed = 0;
+    if (!header_done_) {
+        ARROW_RETURN_NOT_OK(decode_header(data, size, &pos));
+        if (!header_done_) {
+            return arrow::Status::OK();
+        }
+    }
+
+    ARROW_RETURN_NOT_OK(presize(row_limit));
+    auto const n_columns = columns_.size();
+    while (!finished_ && num_rows_ < row_limit && size - pos >= 2) {
+        if (tuple_stride_ > 0) {
+            int64_t max_rows = std::min((size - pos) / tuple_stride_, row_limit - num_rows_);
+            int64_t n = count_strided(data, pos, max_rows);
+            if (n > 0) {
+                ARROW_RETURN_NOT_OK(decode_strided(data + pos, n));
+                pos += n * tuple_stride_;
+                continue;
+            }
+        }
+        if (unpack_int16(data + pos) == -1) {
+            finished_ = true;
+            pos += 2;
+            break;
+        }
+        int64_t end;
+        ARROW_RETURN_NOT_OK(scan_tuple(data, size, pos, &end));
+        if (end == -1) {
+            break;
+        }
+
+        for (std::size_t i = 0; i != n_columns; ++i) {
+            if (field_length_[i] == -1) {
+                ARROW_RETURN_NOT_OK(columns_[i]->append_null());
+            } else {
+                ARROW_RETURN_NOT_OK(columns_[i]->append(field_data_[i], field_length_[i]));
+            }
+        }
+        ++num_rows_;
+        pos = end;
+    }
+
+    *consumed = pos;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::build_index(const char* data, int64_t size, int64_t* consumed)
+{
+    auto const n_columns = columns_.size();
+    int64_t pos = 0;
+    index_.tuple_offsets.clear();
+    for (auto& offsets : index_.field_offsets) {
+        offsets.clear();
+    }
+
+    while (!finished_ && size - pos >= 2) {
+        if (unpack_int16(data + pos) == -1) {
+            finished_ = true;
+            pos += 2;
+            break;
+        }
+        int64_t end;
+        ARROW_RETURN_NOT_OK(scan_tuple(data, size, pos, &end));
+        if (end == -1) {
+            break;
+        }
+        if (end - pos > std::numeric_limits<uint32_t>::max()) {
+            return arrow::Status::CapacityError("tuple of ", end - pos, " bytes is too large to index");
+        }
+
+        index_.tuple_offsets.push_back(pos);
+        for (std::size_t i = 0; i != n_columns; ++i) {
+            // offset of the length word preceding the field
+            index_.field_offsets[i].push_back(static_cast<uint32_t>(field_data_[i] - 4 - (data + pos)));
+        }
+        pos = end;
+    }
+
+    *consumed = pos;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::decode_parallel(const char* data, int64_t size, int64_t* consumed)
+{
+    int64_t pos = 0;
+    *consumed = 0;
+    if (!header_done_) {
+        ARROW_RETURN_NOT_OK(decode_header(data, size, &pos));
+        if (!header_done_) {
+            return arrow::Status::OK();
+        }
+    }
+
+    ARROW_RETURN_NOT_OK(presize(std::numeric_limits<int64_t>::max()));
+    int64_t indexed = 0;
+    ARROW_RETURN_NOT_OK(build_index(data + pos, size - pos, &indexed));
+
+    auto const n_rows = index_.num_rows();
+    auto const base = data + pos;
+    ARROW_RETURN_NOT_OK(arrow::internal::ParallelFor(
+        static_cast<int>(columns_.size()), [&](int i) {
+            return columns_[i]->append_indexed(base, index_.tuple_offsets.data(),
+                                               index_.field_offsets[i].data(), n_rows);
+        }));
+
+    num_rows_ += n_rows;
+    *consumed = pos + indexed;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::decode_all(const char* data, int64_t size,
+                                       const std::function<void(int64_t, int64_t)>& before_window)
+{
+    bool const parallel = options_.use_threads && columns_.size() > 1 && tuple_stride_ < 0;
+    int64_t const window = std::max<int64_t>(options_.window_size, 1);
+    int64_t pos = 0;
+    int64_t window_end = std::min(window, size);
+
+    while (!finished_) {
+        if (before_window) {
+            before_window(pos, window_end - pos);
+        }
+        int64_t consumed = 0;
+        if (parallel) {
+            ARROW_RETURN_NOT_OK(decode_parallel(data + pos, window_end - pos, &consumed));
+        } else {
+            ARROW_RETURN_NOT_OK(decode(data + pos, window_end - pos, &consumed));
+        }
+        if (pos == 0 && options_.expected_rows < 0) {
+            ARROW_RETURN_NOT_OK(reserve_estimate(num_rows_, consumed, size - consumed));
+        }
+        pos += consumed;
+        if (window_end == size) {
+            break;
+        }
+        // a tuple crossing the window end is picked up by the next window,
+        // which grows further if a single tuple is larger than a window
+        int64_t next_end = pos + window;
+        if (next_end <= window_end) {
+            next_end = window_end + window;
+        }
+        window_end = std::min(next_end, size);
+    }
+
+    if (!finished_) {
+        return arrow::Status::Invalid("COPY BINARY data ends without trailer after ",
+                                      pos, " of ", size, " bytes");
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::flush(std::shared_ptr<arrow::RecordBatch>* out)
+{
+    std::vector<std::shared_ptr<arrow::Array>> arrays(columns_.size());
+    for (std::size_t i = 0; i != columns_.size(); ++i) {
+        ARROW_RETURN_NOT_OK(columns_[i]->finish(&arrays[i]));
+        auto const field = schema_->field(static_cast<int>(i));
+        if (!arrays[i]->type()->Equals(*field->type())) {
+            ARROW_ASSIGN_OR_RAISE(schema_, schema_->SetField(static_cast<int>(i), field->WithType(arrays[i]->type())));
+        }
+    }
+    *out = arrow::RecordBatch::Make(schema_, num_rows_, std::move(arrays));
+    flushed_rows_ += num_rows_;
+    num_rows_ = 0;
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::finish_table(std::shared_ptr<arrow::Table>* out)
+{
+    if (!finished_) {
+        return arrow::Status::Invalid("COPY BINARY data ends without trailer");
+    }
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_RETURN_NOT_OK(flush(&batch));
+    return make_table({batch}, out);
+}
+
+arrow::Status copy_decoder::make_table(const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+                                       std::shared_ptr<arrow::Table>* out) const
+{
+    if (batches.empty()) {
+        ARROW_ASSIGN_OR_RAISE(*out, arrow::Table::FromRecordBatches(schema_, batches));
+        return arrow::Status::OK();
+    }
+
+    // a column takes its type from the batches holding values, where it is
+    // plain if it fell back to plain values in any of them
+    auto schema = batches.front()->schema();
+    for (int i = 0; i < schema->num_fields(); ++i) {
+        std::shared_ptr<arrow::DataType> type;
+        for (auto const& batch : batches) {
+            auto const& column = batch->column(i);
+            if (column->null_count() < column->length() &&
+                (!type || (type->id() == arrow::Type::DICTIONARY && column->type_id() != arrow::Type::DICTIONARY))) {
+                type = column->type();
+            }
+        }
+        if (type && !type->Equals(*schema->field(i)->type())) {
+            ARROW_ASSIGN_OR_RAISE(schema, schema->SetField(i, schema->field(i)->WithType(type)));
+        }
+    }
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> unified;
+    for (auto const& batch : batches) {
+        auto columns = batch->columns();
+        for (int i = 0; i < schema->num_fields(); ++i) {
+            auto const& type = schema->field(i)->type();
+            auto const column = columns[i];
+            if (column->type()->Equals(*type)) {
+                continue;
+            }
+            if (column->null_count() == column->length()) {
+                // decoders whose type depends on the values have not
+                // settled on it in batches without any
+                ARROW_ASSIGN_OR_RAISE(columns[i], arrow::MakeArrayOfNull(type, column->length(), pool_));
+            } else if (column->type()->Equals(*arrow::dictionary(arrow::int32(), arrow::utf8())) &&
+                       type->Equals(*plain_text_type(options_.types))) {
+                ARROW_RETURN_NOT_OK(decode_dictionary(*column, type, pool_, &columns[i]));
+            } else {
+                return arrow::Status::Invalid("column '", schema->field(i)->name(), "' is ", column->type()->ToString(),
+                                              " in some batches and ", type->ToString(), " in others");
+            }
+        }
+        unified.push_back(arrow::RecordBatch::Make(schema, batch->num_rows(), std::move(columns)));
+    }
+    ARROW_ASSIGN_OR_RAISE(*out, arrow::Table::FromRecordBatches(schema, unified));
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::decode_table(const char* data, int64_t size, std::shared_ptr<arrow::Table>* out,
+                                         const std::function<void(int64_t, int64_t)>& before_window)
+{
+    int const n_threads = arrow::GetCpuThreadPoolCapacity();
+    int64_t const n_chunks = size / std::max<int64_t>(options_.chunk_size, 1);
+    bool chunked = false;
+    if (options_.use_threads && !header_done_ && n_chunks >= 2) {
+        chunked = options_.parallel == parallel_mode::chunks ||
+                  (options_.parallel == parallel_mode::automatic &&
+                   static_cast<int64_t>(columns_.size()) < n_threads);
+    }
+    for (auto const& spec : specs_) {
+        // each chunk would infer a json struct type of its own
+        if (spec.json_struct && !spec.json_type) {
+            chunked = false;
+        }
+    }
+    if (!chunked) {
+        ARROW_RETURN_NOT_OK(decode_all(data, size, before_window));
+        return finish_table(out);
+    }
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    ARROW_RETURN_NOT_OK(decode_chunks(data, size, static_cast<int>(std::min<int64_t>(n_chunks, 1 << 16)),
+                                      &batches, before_window));
+    return make_table(batches, out);
+}
+
+arrow::Status copy_decoder::make_worker(std::unique_ptr<copy_decoder>* out) const
+{
+    // workers already run on the thread pool, they must not wait on it
+    decode_options options = options_;
+    options.use_threads = false;
+    options.expected_rows = -1;
+    ARROW_RETURN_NOT_OK(make(specs_, options, pool_, out));
+    (*out)->header_done_ = true;
+    (*out)->set_source(source_);
+    return arrow::Status::OK();
+}
+
+arrow::Status copy_decoder::decode_range(const char* data, int64_t size, int64_t start, int64_t stop_at,
+                                         int64_t* end)
+{
+    auto const n_columns = columns_.size();
+    int64_t pos = start;
+    bool estimated = false;
+    while (pos < stop_at) {
+        if (!estimated && num_rows_ >= ESTIMATE_ROWS) {
+            ARROW_RETURN_NOT_OK(reserve_estimate(num_rows_, pos - start, stop_at - pos));
+            estimated = true;
+        }
+        if (tuple_stride_ > 0) {
+            // every tuple starting before stop_at, as far as the data goes
+            int64_t max_rows = std::min((stop_at - pos + tuple_stride_ - 1) / tuple_stride_,
+                                        (size - pos) / tuple_stride_);
+            int64_t n = count_strided(data, pos, max_rows);
+            if (n > 0) {
+                ARROW_RETURN_NOT_OK(decode_strided(data + pos, n));
+                pos += n * tuple_stride_;
+                continue;
+            }
+        }
+        if (size - pos < 2) {
+            break;
+        }
+        if (unpack_int16(data + pos) == -1) {
+            finished_ = true;
+            break;
+        }
+        int64_t tuple_end;
+        ARROW_RETURN_NOT_OK(scan_tuple(data, size, pos, &tuple_end));
+        if (tuple_end == -1) {
+            return arrow::Status::Invalid("COPY BINARY data ends in the middle of a tuple at ", pos);
+        }
+        for (std::size_t i = 0; i != n_columns; ++i) {
+            if (field_length_[i] == -1) {
+                ARROW_RETURN_NOT_OK(columns_[i]->append_null());
+            } else {
+                ARROW_RETURN_NOT_OK(columns_[i]->append(field_data_[i], field_length_[i]));
+            }
+        }
+        ++num_rows_;
+        pos = tuple_end;
+    }
+    *end = pos;
+    return arrow::Status::OK();
+}
+
+bool copy_decoder::plausible_tuples(const char* data, int64_t size, int64_t pos, int n_tuples) const
+{
+    auto const n_columns = static_cast<int16_t>(columns_.size());
+    for (int t = 0; t < n_tuples; ++t) {
+        if (size - pos < 2) {
+            return false;
+        }
+        int16_t n_fields = unpack_int16(data + pos);
+        if (n_fields == -1) {
+            // only the real trailer ends the data
+            return pos == size - 2;
+        }
+        if (n_fields != n_columns) {
+            return false;
+        }
+        pos += 2;
+        for (int16_t i = 0; i < n_fields; ++i) {
+            if (size - pos < 4) {
+                return false;
+            }
+            int32_t length = unpack_int32(data + pos);
+            pos += 4;
+            if (length == -1) {
+                continue;
+            }
+            int32_t width = columns_[i]->fixed_width();
+            if (length < 0 || (width >= 0 && length != width) || size - pos < length) {
+                return false;
+            }
+            pos += length;
+        }
+    }
+    return true;
+}
+
+int64_t copy_decoder::find_boundary(const char* data, int64_t size, int64_t from, int64_t to) const
+{
+    auto const n_columns = static_cast<int16_t>(columns_.size());
+    to = std::min(to, size - 1);
+    for (int64_t pos = from; pos < to; ++pos) {
+        int16_t n_fields = unpack_int16(data + pos);
+        if (n_fields == -1 && pos == size - 2) {
+            return pos;
+        }
+        if (n_fields == n_columns && plausible_tuples(data, size, pos, RESYNC_TUPLES)) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+arrow::Status copy_decoder::decode_chunks(const char* data, int64_t size, int n_chunks,
+                                          std::vector<std::shared_ptr<arrow::RecordBatch>>* out,
+                                          const std::function<void(int64_t, int64_t)>& before_window)
+{
+    int64_t body = 0;
+    ARROW_RETURN_NOT_OK(decode_header(data, size, &body));
+    if (!header_done_) {
+        return arrow::Status::Invalid("COPY BINARY data ends inside the header");
+    }
+
+    struct chunk {
+        int64_t begin;
+        int64_t end;
+        int64_t start;
+        int64_t stop;
+        std::unique_ptr<copy_decoder> decoder;
+        arrow::Status status;
+    };
+    std::vector<chunk> chunks(std::max(n_chunks, 1));
+    int64_t const step = (size - body) / static_cast<int64_t>(chunks.size());
+    for (std::size_t i = 0; i != chunks.size(); ++i) {
+        chunks[i].begin = body + static_cast<int64_t>(i) * step;
+        chunks[i].end = (i + 1 == chunks.size()) ? size : chunks[i].begin + step;
+        chunks[i].start = -1;
+        chunks[i].stop = -1;
+        ARROW_RETURN_NOT_OK(make_worker(&chunks[i].decoder));
+    }
+
+    auto decode_chunk = [&](chunk& c, int64_t start) {
+        c.start = start;
+        c.stop = -1;
+        c.status = c.decoder->decode_range(data, size, start, c.end, &c.stop);
+    };
+
+    // speculative pass, errors in chunks with a wrong guess are expected
+    ARROW_RETURN_NOT_OK(arrow::internal::ParallelFor(
+        static_cast<int>(chunks.size()), [&](int i) {
+            chunk& c = chunks[i];
+            if (before_window) {
+                before_window(c.begin, c.end - c.begin);
+            }
+            int64_t start = (i == 0) ? c.begin : find_boundary(data, size, c.begin, c.end);
+            if (start != -1) {
+                decode_chunk(c, start);
+            }
+            return arrow::Status::OK();
+        }));
+
+    // verification pass: each chunk has to start where the previous stopped
+    int64_t expected = body;
+    bool done = false;
+    for (auto& c : chunks) {
+        if (done || expected >= c.end) {
+            // a tuple (or the trailer) covers this whole chunk
+            c.decoder.reset();
+            continue;
+        }
+        if (c.start != expected) {
+            ARROW_RETURN_NOT_OK(make_worker(&c.decoder));
+            decode_chunk(c, expected);
+        }
+        ARROW_RETURN_NOT_OK(c.status);
+        expected = c.stop;
+        done = c.decoder->finished();
+    }
+    if (!done) {
+        return arrow::Status::Invalid("COPY BINARY data ends without trailer");
+    }
+
+    for (auto& c : chunks) {
+        if (c.decoder) {
+            std::shared_ptr<arrow::RecordBatch> batch;
+            ARROW_RETURN_NOT_OK(c.decoder->flush(&batch));
+            out->push_back(std::move(batch));
+        }
+    }
+    finished_ = true;
+    return merge_dictionaries(out);
+}
+
+arrow::Status copy_decoder::merge_dictionaries(std::vector<std::shared_ptr<arrow::RecordBatch>>* batches) const
+{
+    auto const dictionary_type = arrow::dictionary(arrow::int32(), arrow::utf8());
+    auto const plain_type = plain_text_type(options_.types);
+    for (std::size_t i = 0; i != columns_.size(); ++i) {
+        auto const column = static_cast<int>(i);
+        std::vector<std::shared_ptr<arrow::Array>> arrays;
+        for (auto const& batch : *batches) {
+            if (!batch->column(column)->type()->Equals(*dictionary_type)) {
+                // not a dictionary column, or one that gave up on its own
+                arrays.clear();
+                break;
+            }
+            arrays.push_back(batch->column(column));
+        }
+        bool give_up = false;
+        if (!arrays.empty()) {
+            ARROW_RETURN_NOT_OK(would_give_up(arrays, options_.types.dictionary_max_size, pool_, &give_up));
+        }
+        if (!give_up) {
+            continue;
+        }
+        for (auto& batch : *batches) {
+            std::shared_ptr<arrow::Array> plain;
+            ARROW_RETURN_NOT_OK(decode_dictionary(*batch->column(column), plain_type, pool_, &plain));
+            ARROW_ASSIGN_OR_RAISE(batch, batch->SetColumn(column, batch->schema()->field(column)->WithType(plain_type),
+                                                          plain));
+        }
+    }
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/**
+ * @brief How a complete payload is spread over threads
+ */
+enum class parallel_mode {
+    /// chunks for tables narrower than the thread pool, columns otherwise
+    automatic,
+    /// index each window, then decode the columns independently
+    columns,
+    /// split the payload into byte ranges decoded into separate batches
+    chunks
+};
+
+/**
+ * @brief Settings shared by all columns of one decode
+ */
+struct decode_options {
+    /// decode on the Arrow CPU thread pool
+    bool use_threads = true;
+    parallel_mode parallel = parallel_mode::automatic;
+    /// bytes handed to the decoder at once when decoding column-parallel
+    int64_t window_size = int64_t(64) << 20;
+    /// minimum bytes per chunk when decoding chunk-parallel
+    int64_t chunk_size = int64_t(16) << 20;
+    /// rows the whole stream is expected to hold (e.g. from the table
+    /// statistics), or -1 to estimate them from the data
+    int64_t expected_rows = -1;
+    type_options types;
+};
+
+/**
+ * @brief Offsets of the tuples in a window of COPY data and of the fields
+ *        within them, so each column can later be decoded on its own.
+ *
+ * Field offsets are kept per column and relative to their tuple, pointing
+ * at the field's length word, which keeps them at 4 bytes per field.
+ */
+struct row_index {
+    std::vector<int64_t> tuple_offsets;
+    std::vector<std::vector<uint32_t>> field_offsets;
+
+    int64_t num_rows() const { return static_cast<int64_t>(tuple_offsets.size()); }
+};
+
+/**
+ * @brief Decodes PG COPY ... WITH (FORMAT BINARY) output into Arrow columns.
+ *
+ * The decoder walks a contiguous buffer with plain pointer arithmetic and
+ * never touches Python, so callers can (and should) release the GIL around
+ * decode(). Input can be handed over in pieces: decode() only ever consumes
+ * whole tuples and reports how far it got.
+ *
+ * When every column has a fixed width, tuples without NULLs all have the
+ * same length. Runs of such tuples are decoded as an array of structs with
+ * a constant stride, each column gathered straight out of the payload;
+ * only tuples containing a NULL go through the general per-field path.
+ */
+class copy_decoder {
+  public:
+    /**
+     * @brief Create a decoder for a stream with the given columns
+     */
+    static arrow::Status make(const std::vector<column_spec>& columns, const decode_options& options,
+                              arrow::MemoryPool* pool, std::unique_ptr<copy_decoder>* out);
+
+    /**
+     * @brief Decode the file header (on first call) and as many complete
+     *        tuples as `data` holds. `consumed` is set to the number of bytes
+     *        used; the rest must be passed again, followed by more data.
+     *        Decoding also stops once num_rows() reaches `row_limit`.
+     */
+    arrow::Status decode(const char* data, int64_t size, int64_t* consumed,
+                         int64_t row_limit = std::numeric_limits<int64_t>::max());
+
+    /**
+     * @brief Same contract as decode(), but in two passes: first index all
+     *        complete tuples, then decode every column independently on the
+     *        CPU thread pool
+     */
+    arrow::Status decode_parallel(const char* data, int64_t size, int64_t* consumed);
+
+    /**
+     * @brief Decode a complete COPY BINARY payload one window at a time,
+     *        using decode_parallel() when threads are enabled and the table
+     *        has more than one column, not all of them fixed width.
+     *        `before_window` (if set) is told about each byte range before
+     *        it is decoded. Unless the row count is known up front, the
+     *        columns are sized after the first window for as many rows as
+     *        the rest of the payload holds at the same bytes per row.
+     */
+    arrow::Status decode_all(const char* data, int64_t size,
+                             const std::function<void(int64_t, int64_t)>& before_window = nullptr);
+
+    /**
+     * @brief Decode a complete COPY BINARY payload into a table, either with
+     *        decode_all() or, if chunk-parallel decoding applies, with
+     *        decode_chunks(). Chunks are not used for json struct columns
+     *        whose type is inferred. `before_window` is passed on to either.
+     */
+    arrow::Status decode_table(const char* data, int64_t size, std::shared_ptr<arrow::Table>* out,
+                               const std::function<void(int64_t, int64_t)>& before_window = nullptr);
+
+    /**
+     * @brief Decode a complete COPY BINARY payload as `n_chunks` byte ranges
+     *        on the CPU thread pool, one record batch per range.
+     *
+     * Each range after the first starts decoding at the first position that
+     * looks like a tuple boundary: a field count matching the schema,
+     * followed by a chain of plausible field lengths over several tuples.
+     * Since every range stops at the first tuple starting past its end, the
+     * guesses are verified afterwards against where the previous range
+     * actually stopped, and ranges with a wrong guess are decoded again from
+     * the right position. The result is the same as decoding sequentially.
+     */
+    arrow::Status decode_chunks(const char* data, int64_t size, int n_chunks,
+                                std::vector<std::shared_ptr<arrow::RecordBatch>>* out,
+                                const std::function<void(int64_t, int64_t)>& before_window = nullptr);
+
+    /**
+     * @brief Buffer holding the data passed to the following decode calls,
+     *        which columns may reference from their arrays instead of
+     *        copying values out of it (see type_options::string_view)
+     */
+    void set_source(std::shared_ptr<arrow::Buffer> source);
+
+    /**
+     * @brief Make room in every column for about `n` more rows
+     */
+    arrow::Status reserve(int64_t n);
+
+    /**
+     * @brief Turn the rows decoded since the last flush into a record batch.
+     *        The schema follows columns that changed their type (see
+     *        dictionary_decoder).
+     */
+    arrow::Status flush(std::shared_ptr<arrow::RecordBatch>* out);
+
+    /**
+     * @brief Assemble batches of this decoder (or of its workers) into a
+     *        table. Where a dictionary column fell back to plain values in
+     *        some batches, its dictionary chunks are decoded to match; where
+     *        a column is all NULL in a batch, it takes the type the others
+     *        have. Columns of other differing types fail.
+     */
+    arrow::Status make_table(const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+                             std::shared_ptr<arrow::Table>* out) const;
+
+    /**
+     * @brief Flush the remaining rows as a table, failing if the trailer has
+     *        not been seen
+     */
+    arrow::Status finish_table(std::shared_ptr<arrow::Table>* out);
+
+    /**
+     * @brief True once the end-of-data trailer has been seen
+     */
+    bool finished() const { return finished_; }
+
+    /**
+     * @brief Rows decoded since the last flush
+     */
+    int64_t num_rows() const { return num_rows_; }
+
+    std::shared_ptr<arrow::Schema> schema() const { return schema_; }
+
+  private:
+    copy_decoder(std::vector<column_spec> specs, std::vector<std::unique_ptr<column_decoder>> columns,
+                 std::shared_ptr<arrow::Schema> schema, const decode_options& options,
+                 arrow::MemoryPool* pool);
+
+    /**
+     * @brief Create a decoder for the same columns that starts after the header
+     */
+    arrow::Status make_worker(std::unique_ptr<copy_decoder>* out) const;
+
+    /**
+     * @brief Decode the tuples starting at `start` up to the first one
+     *        starting at or after `stop_at` (or the trailer). `end` is set to
+     *        where decoding stopped.
+     */
+    arrow::Status decode_range(const char* data, int64_t size, int64_t start, int64_t stop_at,
+                               int64_t* end);
+
+    /**
+     * @brief Decode the dictionary columns of the batches of decode_chunks()
+     *        to plain values where their distinct values together are too
+     *        many, as they would have been for a single decoder
+     */
+    arrow::Status merge_dictionaries(std::vector<std::shared_ptr<arrow::RecordBatch>>* batches) const;
+
+    /**
+     * @brief Find the first plausible tuple boundary in [from, to), or -1
+     */
+    int64_t find_boundary(const char* data, int64_t size, int64_t from, int64_t to) const;
+
+    /**
+     * @brief Check that `n_tuples` consecutive tuples (or all up to the
+     *        trailer) starting at `pos` are consistent with the schema
+     */
+    bool plausible_tuples(const char* data, int64_t size, int64_t pos, int n_tuples) const;
+
+    arrow::Status decode_header(const char* data, int64_t size, int64_t* consumed);
+
+    /**
+     * @brief At the start of a batch of at most `row_limit` rows, reserve
+     *        the rows options_.expected_rows says are still to come
+     */
+    arrow::Status presize(int64_t row_limit);
+
+    /**
+     * @brief Reserve the rows expected in `remaining` more bytes, judging
+     *        by `rows` having taken up `bytes`
+     */
+    arrow::Status reserve_estimate(int64_t rows, int64_t bytes, int64_t remaining);
+
+    /**
+     * @brief Number of consecutive NULL-free tuples of tuple_stride_ bytes
+     *        starting at `pos`, looking at no more than `max_rows` of them
+     */
+    int64_t count_strided(const char* data, int64_t pos, int64_t max_rows) const;
+
+    /**
+     * @brief Decode `n` tuples of tuple_stride_ bytes starting at `data`
+     */
+    arrow::Status decode_strided(const char* data, int64_t n);
+
+    /**
+     * @brief Locate the fields of the tuple at `pos` in field_data_ and
+     *        field_length_. `end` is set past the tuple, or to -1 if the
+     *        tuple does not fit in `size` bytes.
+     */
+    arrow::Status scan_tuple(const char* data, int64_t size, int64_t pos, int64_t* end);
+
+    /**
+     * @brief First pass of decode_parallel(): fill index_ with the complete
+     *        tuples of `data`, stopping at the trailer
+     */
+    arrow::Status build_index(const char* data, int64_t size, int64_t* consumed);
+
+    std::vector<column_spec> specs_;
+    std::vector<std::unique_ptr<column_decoder>> columns_;
+    std::shared_ptr<arrow::Schema> schema_;
+    decode_options options_;
+    arrow::MemoryPool* pool_;
+    std::shared_ptr<arrow::Buffer> source_;
+    // scratch space holding the fields of the tuple being decoded
+    std::vector<const char*> field_data_;
+    std::vector<int32_t> field_length_;
+    row_index index_;
+    // length of a tuple without NULLs if all columns are fixed width, else -1
+    int64_t tuple_stride_;
+    // with a tuple stride: width of each column and offset of its length
+    // word within the tuple
+    std::vector<int32_t> field_widths_;
+    std::vector<int64_t> field_offsets_;
+    bool header_done_;
+    bool finished_;
+    int64_t num_rows_;
+    // rows handed out by flush() so far
+    int64_t flushed_rows_;
+};
+
+}
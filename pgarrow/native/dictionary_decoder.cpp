@@ -0,0 +1,177 @@
+#include "dictionary_decoder.h"
+
+#include "binary_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+// rows a batch needs before its share of distinct values is judged
+constexpr int64_t DICTIONARY_SAMPLE_ROWS = 1 << 12;
+
+/**
+ * @brief Whether a dictionary of `size` values after `rows` rows is no
+ *        longer worth keeping
+ */
+bool too_many_distinct(int32_t size, int64_t rows, int32_t max_size)
+{
+    return size > max_size || (rows >= DICTIONARY_SAMPLE_ROWS && 2 * static_cast<int64_t>(size) > rows);
+}
+
+/**
+ * @brief Append the values of a dictionary<int32, utf8> array to `target`
+ */
+arrow::Status append_decoded(const arrow::Array& array, column_decoder* target)
+{
+    auto const& indices = static_cast<const arrow::DictionaryArray&>(array);
+    auto const& dictionary = static_cast<const arrow::StringArray&>(*indices.dictionary());
+    auto const* index = indices.indices()->data()->GetValues<int32_t>(1);
+    ARROW_RETURN_NOT_OK(target->reserve(array.length()));
+    for (int64_t i = 0; i < array.length(); ++i) {
+        if (array.IsNull(i)) {
+            ARROW_RETURN_NOT_OK(target->append_null());
+        } else {
+            auto const value = dictionary.GetView(index[i]);
+            ARROW_RETURN_NOT_OK(target->append(value.data(), static_cast<int32_t>(value.size())));
+        }
+    }
+    return arrow::Status::OK();
+}
+
+}
+
+dictionary_decoder::dictionary_decoder(std::unique_ptr<column_decoder> fallback, int32_t max_size,
+                                       arrow::MemoryPool* pool) :
+    fallback_(std::move(fallback)),
+    max_size_(max_size),
+    gave_up_(false),
+    indices_(pool),
+    validity_(pool),
+    dictionary_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> dictionary_decoder::type() const
+{
+    if (gave_up_) {
+        return fallback_->type();
+    }
+    return arrow::dictionary(arrow::int32(), arrow::utf8());
+}
+
+arrow::Status dictionary_decoder::append(const char* data, int32_t length)
+{
+    if (gave_up_) {
+        return fallback_->append(data, length);
+    }
+    int32_t index;
+    ARROW_RETURN_NOT_OK(dictionary_.get_or_insert(data, length, &index));
+    ARROW_RETURN_NOT_OK(indices_.Append(index));
+    ARROW_RETURN_NOT_OK(validity_.append_valid());
+
+    int32_t const size = dictionary_.size();
+    if (index + 1 == size && too_many_distinct(size, indices_.length(), max_size_)) {
+        return give_up();
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status dictionary_decoder::append_null()
+{
+    if (gave_up_) {
+        return fallback_->append_null();
+    }
+    ARROW_RETURN_NOT_OK(indices_.Append(0));
+    return validity_.append_null();
+}
+
+arrow::Status dictionary_decoder::reserve(int64_t n)
+{
+    if (gave_up_) {
+        return fallback_->reserve(n);
+    }
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return indices_.Reserve(n);
+}
+
+arrow::Status dictionary_decoder::give_up()
+{
+    std::shared_ptr<arrow::Array> batch;
+    ARROW_RETURN_NOT_OK(finish_dictionary(&batch));
+    gave_up_ = true;
+    return append_decoded(*batch, fallback_.get());
+}
+
+arrow::Status dictionary_decoder::finish_dictionary(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = indices_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    std::shared_ptr<arrow::Buffer> indices;
+    std::shared_ptr<arrow::Array> dictionary;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(indices_.Finish(&indices));
+    ARROW_RETURN_NOT_OK(dictionary_.finish(&dictionary));
+
+    auto array = arrow::ArrayData::Make(arrow::dictionary(arrow::int32(), arrow::utf8()), length,
+                                        {validity, indices}, null_count);
+    array->dictionary = dictionary->data();
+    *out = arrow::MakeArray(std::move(array));
+    return arrow::Status::OK();
+}
+
+arrow::Status dictionary_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (gave_up_) {
+        return fallback_->finish(out);
+    }
+    return finish_dictionary(out);
+}
+
+arrow::Status decode_dictionary(const arrow::Array& array, const std::shared_ptr<arrow::DataType>& type,
+                                arrow::MemoryPool* pool, std::shared_ptr<arrow::Array>* out)
+{
+    std::unique_ptr<column_decoder> target;
+    if (type->id() == arrow::Type::STRING_VIEW) {
+        target.reset(new binary_view_decoder(type, pool));
+    } else if (type->id() == arrow::Type::LARGE_STRING) {
+        target.reset(new binary_decoder<int64_t>(type, pool));
+    } else {
+        target.reset(new binary_decoder<int32_t>(type, pool));
+    }
+    ARROW_RETURN_NOT_OK(append_decoded(array, target.get()));
+    return target->finish(out);
+}
+
+arrow::Status would_give_up(const std::vector<std::shared_ptr<arrow::Array>>& arrays, int32_t max_size,
+                            arrow::MemoryPool* pool, bool* out)
+{
+    string_dictionary distinct(pool);
+    // whether each value of the current array's dictionary was counted yet
+    std::vector<char> counted;
+    int64_t rows = 0;
+    *out = false;
+    for (auto const& array : arrays) {
+        auto const& indices = static_cast<const arrow::DictionaryArray&>(*array);
+        auto const& dictionary = static_cast<const arrow::StringArray&>(*indices.dictionary());
+        auto const* index = indices.indices()->data()->GetValues<int32_t>(1);
+        counted.assign(dictionary.length(), 0);
+        for (int64_t i = 0; i < array->length(); ++i) {
+            ++rows;
+            if (array->IsNull(i) || counted[index[i]]) {
+                continue;
+            }
+            counted[index[i]] = 1;
+            auto const value = dictionary.GetView(index[i]);
+            int32_t position;
+            ARROW_RETURN_NOT_OK(distinct.get_or_insert(value.data(), static_cast<int32_t>(value.size()), &position));
+            if (position + 1 == distinct.size() && too_many_distinct(distinct.size(), rows, max_size)) {
+                *out = true;
+                return arrow::Status::OK();
+            }
+        }
+    }
+    return arrow::Status::OK();
+}
+
+}
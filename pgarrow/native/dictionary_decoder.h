@@ -0,0 +1,164 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+#include "string_dictionary.h"
+
+namespace pgarrow {
+
+/**
+ * @brief Decoder for text columns into dictionary<int32, utf8> arrays,
+ *        for columns with few distinct values.
+ *
+ * Each value is looked up in (or added to) a string_dictionary. Every batch
+ * starts a new dictionary.
+ *
+ * Once a batch holds more than `max_size` distinct values, or more than
+ * half of its (at least DICTIONARY_SAMPLE_ROWS) rows are distinct, the
+ * column gives up: the rows so far are replayed into `fallback` and all
+ * later rows, in this and the following batches, go there directly.
+ * type() then reports the fallback type.
+ */
+class dictionary_decoder : public column_decoder {
+  public:
+    dictionary_decoder(std::unique_ptr<column_decoder> fallback, int32_t max_size, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    void set_source(std::shared_ptr<arrow::Buffer> source) override { fallback_->set_source(std::move(source)); }
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Replay the rows of the batch into the fallback decoder
+     */
+    arrow::Status give_up();
+
+    /**
+     * @brief Hand out the batch as a dictionary array and start a new dictionary
+     */
+    arrow::Status finish_dictionary(std::shared_ptr<arrow::Array>* out);
+
+    std::unique_ptr<column_decoder> fallback_;
+    int32_t max_size_;
+    bool gave_up_;
+    arrow::TypedBufferBuilder<int32_t> indices_;
+    validity_bitmap validity_;
+    string_dictionary dictionary_;
+};
+
+/**
+ * @brief Decoder for enum columns into dictionary<Index, utf8> arrays.
+ *
+ * The labels of the enum, in catalog (sort) order, are known up front and
+ * form the dictionary of every batch, so the indices compare like the enum
+ * values do. Enums are sent as their label, which is looked up in a
+ * string_dictionary of the labels; no string is built per row.
+ */
+template <typename Index>
+class enum_decoder : public column_decoder {
+  public:
+    using c_type = typename Index::c_type;
+
+    static arrow::Status make(const std::string& name, const std::vector<std::string>& labels,
+                              arrow::MemoryPool* pool, std::unique_ptr<column_decoder>* out)
+    {
+        std::unique_ptr<enum_decoder> decoder(new enum_decoder(name, pool));
+        for (auto const& label : labels) {
+            int32_t index;
+            ARROW_RETURN_NOT_OK(decoder->labels_.get_or_insert(label.data(), static_cast<int32_t>(label.size()),
+                                                               &index));
+        }
+        if (decoder->labels_.size() != static_cast<int32_t>(labels.size())) {
+            return arrow::Status::Invalid("duplicate labels in enum column '", name, "'");
+        }
+        arrow::StringBuilder dictionary(pool);
+        ARROW_RETURN_NOT_OK(dictionary.AppendValues(labels));
+        ARROW_RETURN_NOT_OK(dictionary.Finish(&decoder->dictionary_));
+        *out = std::move(decoder);
+        return arrow::Status::OK();
+    }
+
+    std::shared_ptr<arrow::DataType> type() const override
+    {
+        return arrow::dictionary(arrow::TypeTraits<Index>::type_singleton(), arrow::utf8(), true);
+    }
+
+    arrow::Status append(const char* data, int32_t length) override
+    {
+        int32_t const index = labels_.find(data, length);
+        if (index == -1) {
+            return arrow::Status::Invalid("unknown label '", std::string(data, length), "' in enum column '",
+                                          name_, "'");
+        }
+        ARROW_RETURN_NOT_OK(validity_.append_valid());
+        return indices_.Append(static_cast<c_type>(index));
+    }
+
+    arrow::Status append_null() override
+    {
+        ARROW_RETURN_NOT_OK(validity_.append_null());
+        return indices_.Append(c_type());
+    }
+
+    arrow::Status reserve(int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(validity_.reserve(n));
+        return indices_.Reserve(n);
+    }
+
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override
+    {
+        int64_t const length = indices_.length();
+        int64_t const null_count = validity_.null_count();
+        std::shared_ptr<arrow::Buffer> validity;
+        std::shared_ptr<arrow::Buffer> indices;
+        ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+        ARROW_RETURN_NOT_OK(indices_.Finish(&indices));
+        auto array = arrow::ArrayData::Make(type(), length, {validity, indices}, null_count);
+        array->dictionary = dictionary_->data();
+        *out = arrow::MakeArray(std::move(array));
+        return arrow::Status::OK();
+    }
+
+  private:
+    enum_decoder(std::string name, arrow::MemoryPool* pool) :
+        name_(std::move(name)),
+        indices_(pool),
+        validity_(pool),
+        labels_(pool)
+    {
+    }
+
+    std::string name_;
+    arrow::TypedBufferBuilder<c_type> indices_;
+    validity_bitmap validity_;
+    string_dictionary labels_;
+    std::shared_ptr<arrow::Array> dictionary_;
+};
+
+/**
+ * @brief Decode a dictionary<int32, utf8> array into plain values of
+ *        `type` (utf8, large_utf8 or utf8_view)
+ */
+arrow::Status decode_dictionary(const arrow::Array& array, const std::shared_ptr<arrow::DataType>& type,
+                                arrow::MemoryPool* pool, std::shared_ptr<arrow::Array>* out);
+
+/**
+ * @brief Whether a dictionary_decoder would have given up on the values of
+ *        the dictionary<int32, utf8> `arrays` one after the other, as one
+ *        batch. Tells if the batches of chunks decoded separately, each
+ *        with its own dictionary, together call for plain values.
+ */
+arrow::Status would_give_up(const std::vector<std::shared_ptr<arrow::Array>>& arrays, int32_t max_size,
+                            arrow::MemoryPool* pool, bool* out);
+
+}
@@ -0,0 +1,382 @@
+#include "geometry_decoder.h"
+
+#include <cstring>
+#include <limits>
+
+namespace pgarrow {
+
+namespace {
+
+constexpr const char* NO_CRS = "{}";
+
+std::shared_ptr<arrow::DataType> float8_struct(const std::vector<std::string>& names)
+{
+    arrow::FieldVector fields;
+    for (auto const& name : names) {
+        fields.push_back(arrow::field(name, arrow::float64(), false));
+    }
+    return arrow::struct_(std::move(fields));
+}
+
+std::shared_ptr<arrow::DataType> geoarrow(std::string name, std::shared_ptr<arrow::DataType> storage,
+                                          std::string metadata = NO_CRS)
+{
+    return std::make_shared<geoarrow_type>(std::move(name), std::move(storage), std::move(metadata));
+}
+
+std::shared_ptr<arrow::DataType> storage_type(const std::shared_ptr<arrow::DataType>& type)
+{
+    if (type->id() == arrow::Type::EXTENSION) {
+        return static_cast<const arrow::ExtensionType&>(*type).storage_type();
+    }
+    return type;
+}
+
+std::shared_ptr<arrow::Array> wrap(const std::shared_ptr<arrow::DataType>& type,
+                                   std::shared_ptr<arrow::ArrayData> storage)
+{
+    auto array = arrow::MakeArray(std::move(storage));
+    if (type->id() == arrow::Type::EXTENSION) {
+        return arrow::ExtensionType::WrapArray(type, array);
+    }
+    return array;
+}
+
+uint32_t unpack_wkb_uint32(const char* buf, bool little_endian)
+{
+    auto const* bytes = reinterpret_cast<const uint8_t*>(buf);
+    if (little_endian) {
+        return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+    }
+    return uint32_t(bytes[3]) | uint32_t(bytes[2]) << 8 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[0]) << 24;
+}
+
+}
+
+float8_struct_decoder::float8_struct_decoder(std::shared_ptr<arrow::DataType> type, std::vector<int32_t> positions,
+                                             arrow::MemoryPool* pool) :
+    type_(std::move(type)),
+    positions_(std::move(positions)),
+    validity_(pool)
+{
+    for (std::size_t i = 0; i != positions_.size(); ++i) {
+        children_.emplace_back(new arrow::TypedBufferBuilder<double>(pool));
+    }
+}
+
+arrow::Status float8_struct_decoder::append(const char* data, int32_t length)
+{
+    if (length != fixed_width()) {
+        return arrow::Status::Invalid("expected field of ", fixed_width(), " bytes for ", type_->ToString(),
+                                      ", got ", length);
+    }
+    return append_strided(data, length, 1);
+}
+
+arrow::Status float8_struct_decoder::append_null()
+{
+    for (auto& child : children_) {
+        ARROW_RETURN_NOT_OK(child->Append(0.0));
+    }
+    return validity_.append_null();
+}
+
+arrow::Status float8_struct_decoder::reserve(int64_t n)
+{
+    for (auto& child : children_) {
+        ARROW_RETURN_NOT_OK(child->Reserve(n));
+    }
+    return validity_.reserve(n);
+}
+
+arrow::Status float8_struct_decoder::append_strided(const char* data, int64_t stride, int64_t n)
+{
+    for (std::size_t i = 0; i != children_.size(); ++i) {
+        auto& child = *children_[i];
+        ARROW_RETURN_NOT_OK(child.Reserve(n));
+        unpack_int64_strided(reinterpret_cast<char*>(child.mutable_data() + child.length()),
+                             data + 8 * positions_[i], stride, n);
+        child.UnsafeAdvance(n);
+    }
+    return validity_.append_valid(n);
+}
+
+arrow::Status float8_struct_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    auto array = arrow::ArrayData::Make(storage_type(type_), length, {validity}, null_count);
+    for (auto& child : children_) {
+        std::shared_ptr<arrow::Buffer> values;
+        ARROW_RETURN_NOT_OK(child->Finish(&values));
+        array->child_data.push_back(arrow::ArrayData::Make(arrow::float64(), length, {nullptr, values}, 0));
+    }
+    *out = wrap(type_, std::move(array));
+    return arrow::Status::OK();
+}
+
+linestring_decoder::linestring_decoder(std::string name, uint32_t oid, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    oid_(oid),
+    polygon_offsets_(pool),
+    offsets_(pool),
+    xs_(pool),
+    ys_(pool),
+    validity_(pool)
+{
+    auto const vertices = arrow::list(arrow::field("vertices", float8_struct({"x", "y"}), false));
+    if (oid_ == POLYGONOID) {
+        type_ = geoarrow("geoarrow.polygon", arrow::list(arrow::field("rings", vertices, false)));
+    } else {
+        type_ = geoarrow("geoarrow.linestring", vertices);
+    }
+}
+
+arrow::Status linestring_decoder::corrupt() const
+{
+    return arrow::Status::Invalid("corrupt geometric field in column '", name_, "'");
+}
+
+arrow::Status linestring_decoder::start()
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    if (oid_ == POLYGONOID && polygon_offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(polygon_offsets_.Append(0));
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status linestring_decoder::append_points(const char* points, int64_t n)
+{
+    ARROW_RETURN_NOT_OK(xs_.Reserve(n));
+    ARROW_RETURN_NOT_OK(ys_.Reserve(n));
+    unpack_int64_strided(reinterpret_cast<char*>(xs_.mutable_data() + xs_.length()), points, POINT_SIZE, n);
+    unpack_int64_strided(reinterpret_cast<char*>(ys_.mutable_data() + ys_.length()), points + 8, POINT_SIZE, n);
+    xs_.UnsafeAdvance(n);
+    ys_.UnsafeAdvance(n);
+    return arrow::Status::OK();
+}
+
+arrow::Status linestring_decoder::append(const char* data, int32_t length)
+{
+    const char* points;
+    int32_t count;
+    bool closed;
+    if (oid_ == LSEGOID) {
+        points = data;
+        count = 2;
+        closed = false;
+    } else if (oid_ == PATHOID) {
+        if (length < PATH_HEADER_SIZE) {
+            return corrupt();
+        }
+        closed = data[0] != 0;
+        count = unpack_int32(data + 1);
+        points = data + PATH_HEADER_SIZE;
+    } else {
+        if (length < POLYGON_HEADER_SIZE) {
+            return corrupt();
+        }
+        count = unpack_int32(data);
+        closed = count > 0;
+        points = data + POLYGON_HEADER_SIZE;
+    }
+    if (count < 0 || length - (points - data) != int64_t(count) * POINT_SIZE) {
+        return corrupt();
+    }
+    closed = closed && count > 0;
+    if (xs_.length() + count + 1 > std::numeric_limits<int32_t>::max()) {
+        return arrow::Status::CapacityError("more than 2^31 points in one batch of column '", name_,
+                                            "', use smaller batches");
+    }
+    ARROW_RETURN_NOT_OK(start());
+    ARROW_RETURN_NOT_OK(append_points(points, count));
+    if (closed) {
+        ARROW_RETURN_NOT_OK(append_points(points, 1));
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(xs_.length())));
+    if (oid_ == POLYGONOID) {
+        ARROW_RETURN_NOT_OK(polygon_offsets_.Append(static_cast<int32_t>(offsets_.length() - 1)));
+    }
+    return validity_.append_valid();
+}
+
+arrow::Status linestring_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(start());
+    if (oid_ == POLYGONOID) {
+        ARROW_RETURN_NOT_OK(polygon_offsets_.Append(static_cast<int32_t>(offsets_.length() - 1)));
+    } else {
+        ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(xs_.length())));
+    }
+    return validity_.append_null();
+}
+
+arrow::Status linestring_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return (oid_ == POLYGONOID ? polygon_offsets_ : offsets_).Reserve(n + 1);
+}
+
+arrow::Status linestring_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    ARROW_RETURN_NOT_OK(start());
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    int64_t const vertices = xs_.length();
+    int64_t const lines = offsets_.length() - 1;
+    std::shared_ptr<arrow::Buffer> validity, polygon_offsets, offsets, xs, ys;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(xs_.Finish(&xs));
+    ARROW_RETURN_NOT_OK(ys_.Finish(&ys));
+
+    auto const storage = storage_type(type_);
+    auto line_type = storage;
+    if (oid_ == POLYGONOID) {
+        line_type = storage->field(0)->type();
+    }
+    auto points = arrow::ArrayData::Make(line_type->field(0)->type(), vertices, {nullptr}, 0);
+    points->child_data.push_back(arrow::ArrayData::Make(arrow::float64(), vertices, {nullptr, xs}, 0));
+    points->child_data.push_back(arrow::ArrayData::Make(arrow::float64(), vertices, {nullptr, ys}, 0));
+    std::shared_ptr<arrow::ArrayData> array;
+    if (oid_ == POLYGONOID) {
+        ARROW_RETURN_NOT_OK(polygon_offsets_.Finish(&polygon_offsets));
+        auto rings = arrow::ArrayData::Make(line_type, lines, {nullptr, offsets}, 0);
+        rings->child_data.push_back(std::move(points));
+        array = arrow::ArrayData::Make(storage, length, {validity, polygon_offsets}, null_count);
+        array->child_data.push_back(std::move(rings));
+    } else {
+        array = arrow::ArrayData::Make(storage, length, {validity, offsets}, null_count);
+        array->child_data.push_back(std::move(points));
+    }
+    *out = wrap(type_, std::move(array));
+    return arrow::Status::OK();
+}
+
+wkb_decoder::wkb_decoder(std::string name, int32_t srid, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    srid_(srid),
+    type_(geoarrow("geoarrow.wkb", arrow::binary(),
+                   srid > 0 ? "{\"crs\": \"" + std::to_string(srid) + "\", \"crs_type\": \"srid\"}" : NO_CRS)),
+    offsets_(pool),
+    data_(pool),
+    validity_(pool)
+{
+}
+
+arrow::Status wkb_decoder::check_srid(int32_t srid) const
+{
+    if (srid_ > 0 && srid != 0 && srid != srid_) {
+        return arrow::Status::Invalid("geometry of SRID ", srid, " in column '", name_, "' of SRID ", srid_);
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status wkb_decoder::append(const char* data, int32_t length)
+{
+    if (length < WKB_HEADER_SIZE || (data[0] != 0 && data[0] != 1)) {
+        return arrow::Status::Invalid("corrupt geometry field in column '", name_, "'");
+    }
+    bool const little_endian = data[0] == 1;
+    char header[WKB_HEADER_SIZE];
+    std::memcpy(header, data, WKB_HEADER_SIZE);
+    const char* body = data + WKB_HEADER_SIZE;
+    int32_t body_length = length - WKB_HEADER_SIZE;
+    if (unpack_wkb_uint32(data + 1, little_endian) & EWKB_SRID_FLAG) {
+        if (body_length < 4) {
+            return arrow::Status::Invalid("corrupt geometry field in column '", name_, "'");
+        }
+        ARROW_RETURN_NOT_OK(check_srid(static_cast<int32_t>(unpack_wkb_uint32(body, little_endian))));
+        // the flag is in the most significant byte of the type
+        header[little_endian ? 4 : 1] &= ~static_cast<char>(EWKB_SRID_FLAG >> 24);
+        body += 4;
+        body_length -= 4;
+    }
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    if (data_.length() + WKB_HEADER_SIZE + body_length > std::numeric_limits<int32_t>::max()) {
+        return arrow::Status::CapacityError("more than 2 GB of geometries in one batch of column '", name_,
+                                            "', use smaller batches");
+    }
+    ARROW_RETURN_NOT_OK(data_.Append(header, WKB_HEADER_SIZE));
+    ARROW_RETURN_NOT_OK(data_.Append(body, body_length));
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+    return validity_.append_valid();
+}
+
+arrow::Status wkb_decoder::append_null()
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+    return validity_.append_null();
+}
+
+arrow::Status wkb_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return offsets_.Reserve(n + 1);
+}
+
+arrow::Status wkb_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity, offsets, data;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(data_.Finish(&data));
+    *out = wrap(type_, arrow::ArrayData::Make(arrow::binary(), length, {validity, offsets, data}, null_count));
+    return arrow::Status::OK();
+}
+
+arrow::Status make_geometry_decoder(const column_spec& spec, arrow::MemoryPool* pool,
+                                    std::unique_ptr<column_decoder>* out)
+{
+    switch (spec.oid) {
+        case POINTOID:
+            out->reset(new float8_struct_decoder(geoarrow("geoarrow.point", float8_struct({"x", "y"})), {0, 1},
+                                                 pool));
+            break;
+        case BOXOID:
+            // sent as the upper right, then the lower left corner
+            out->reset(new float8_struct_decoder(
+                geoarrow("geoarrow.box", float8_struct({"xmin", "ymin", "xmax", "ymax"})), {2, 3, 0, 1}, pool));
+            break;
+        case LINEOID:
+            out->reset(new float8_struct_decoder(float8_struct({"a", "b", "c"}), {0, 1, 2}, pool));
+            break;
+        case CIRCLEOID:
+            out->reset(new float8_struct_decoder(float8_struct({"x", "y", "radius"}), {0, 1, 2}, pool));
+            break;
+        case LSEGOID:
+        case PATHOID:
+        case POLYGONOID:
+            out->reset(new linestring_decoder(spec.name, spec.oid, pool));
+            break;
+        default:
+            return arrow::Status::NotImplemented("no native decoder for column '", spec.name,
+                                                 "' of type oid ", spec.oid);
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status make_postgis_decoder(const column_spec& spec, arrow::MemoryPool* pool,
+                                   std::unique_ptr<column_decoder>* out)
+{
+    int32_t const srid = spec.typmod < 0 ? 0 : (spec.typmod >> POSTGIS_TYPMOD_SRID_SHIFT) & POSTGIS_TYPMOD_SRID_MASK;
+    out->reset(new wkb_decoder(spec.name, srid, pool));
+    return arrow::Status::OK();
+}
+
+}
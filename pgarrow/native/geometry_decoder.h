@@ -0,0 +1,210 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/extension_type.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layouts of the geometric types in the send format (see PG's
+ * utils/adt/geo_ops.c), all made of float8 coordinates, a point being x
+ * then y: box is its upper right then its lower left point, lseg its two
+ * points, path a uint8 closed flag, an int32 number of points and the
+ * points, polygon an int32 number of points and the points (the first is
+ * not repeated at the end), line the A, B and C of Ax + By + C = 0 and
+ * circle its center and radius.
+ */
+constexpr int32_t POINT_SIZE = 16;
+constexpr int32_t PATH_HEADER_SIZE = 5;
+constexpr int32_t POLYGON_HEADER_SIZE = 4;
+
+/*
+ * Layout of PostGIS geometry and geography in the send format: EWKB, that
+ * is WKB (a byte order byte, 0 for big and 1 for little endian, a uint32
+ * geometry type and the coordinates) whose type may carry flags, among
+ * them one for an int32 SRID following it.
+ */
+constexpr int32_t WKB_HEADER_SIZE = 5;
+constexpr uint32_t EWKB_SRID_FLAG = 0x20000000;
+
+/*
+ * PostGIS typmods (see gserialized_typmod.c) hold the SRID in bits 8 to 28,
+ * above the geometry type and the Z and M flags.
+ */
+constexpr int32_t POSTGIS_TYPMOD_SRID_SHIFT = 8;
+constexpr int32_t POSTGIS_TYPMOD_SRID_MASK = 0x1fffff;
+
+/**
+ * @brief GeoArrow extension type (geoarrow.point, geoarrow.wkb, ...) over
+ *        its storage type, with its JSON metadata (CRS) as serialization
+ */
+class geoarrow_type : public arrow::ExtensionType {
+  public:
+    geoarrow_type(std::string name, std::shared_ptr<arrow::DataType> storage, std::string metadata) :
+        arrow::ExtensionType(std::move(storage)),
+        name_(std::move(name)),
+        metadata_(std::move(metadata))
+    {
+    }
+
+    std::string extension_name() const override { return name_; }
+
+    bool ExtensionEquals(const arrow::ExtensionType& other) const override
+    {
+        return other.extension_name() == name_ && other.Serialize() == metadata_ &&
+               other.storage_type()->Equals(*storage_type());
+    }
+
+    std::shared_ptr<arrow::Array> MakeArray(std::shared_ptr<arrow::ArrayData> data) const override
+    {
+        return std::make_shared<arrow::ExtensionArray>(std::move(data));
+    }
+
+    arrow::Result<std::shared_ptr<arrow::DataType>> Deserialize(std::shared_ptr<arrow::DataType> storage,
+                                                                const std::string& serialized) const override
+    {
+        return std::make_shared<geoarrow_type>(name_, std::move(storage), serialized);
+    }
+
+    std::string Serialize() const override { return metadata_; }
+
+  private:
+    std::string name_;
+    std::string metadata_;
+};
+
+/**
+ * @brief Decoder for the geometric types made of a fixed number of float8
+ *        (point, box, line, circle) into struct arrays of float64, such as
+ *        geoarrow.point struct<x, y>.
+ *
+ * Each child gathers its coordinate from the runs of fields with the
+ * strided kernels of hton.h, which swap the bytes of several values per
+ * SIMD instruction; positions_ says where in the field each child's is.
+ */
+class float8_struct_decoder : public column_decoder {
+  public:
+    float8_struct_decoder(std::shared_ptr<arrow::DataType> type, std::vector<int32_t> positions,
+                          arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+    int32_t fixed_width() const override { return 8 * static_cast<int32_t>(positions_.size()); }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status append_strided(const char* data, int64_t stride, int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    std::shared_ptr<arrow::DataType> type_;
+    std::vector<int32_t> positions_;
+    std::vector<std::unique_ptr<arrow::TypedBufferBuilder<double>>> children_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Decoder for lseg and path columns into geoarrow.linestring
+ *        list<vertices: struct<x, y>> arrays, and polygon columns into
+ *        geoarrow.polygon list<rings: list<vertices: struct<x, y>>> arrays
+ *        of one ring.
+ *
+ * The points of a value are contiguous, so x and y are each gathered from
+ * all of them in one strided SIMD pass. Rings and closed paths get their
+ * first point again at the end, as rings have in GeoArrow and WKB.
+ */
+class linestring_decoder : public column_decoder {
+  public:
+    linestring_decoder(std::string name, uint32_t oid, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    arrow::Status corrupt() const;
+
+    /**
+     * @brief Append the first offsets of a batch if not done yet
+     */
+    arrow::Status start();
+
+    /**
+     * @brief Append the x and y of `n` contiguous points
+     */
+    arrow::Status append_points(const char* points, int64_t n);
+
+    std::string name_;
+    uint32_t oid_;
+    std::shared_ptr<arrow::DataType> type_;
+    // offsets of the polygons into the rings, for polygon columns
+    arrow::TypedBufferBuilder<int32_t> polygon_offsets_;
+    // offsets of the linestrings or rings into the vertices
+    arrow::TypedBufferBuilder<int32_t> offsets_;
+    arrow::TypedBufferBuilder<double> xs_;
+    arrow::TypedBufferBuilder<double> ys_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Decoder for PostGIS geometry and geography columns into
+ *        geoarrow.wkb arrays.
+ *
+ * The WKB of each value is copied through as is, except that the SRID of
+ * EWKB is taken out of the header (keeping any Z and M flags, which common
+ * WKB readers accept). The SRID the column is declared with goes into the
+ * CRS of the type's metadata, and values of another SRID fail the decode;
+ * columns declared without one have no CRS, whatever their values say.
+ */
+class wkb_decoder : public column_decoder {
+  public:
+    /**
+     * @brief `srid` is the declared SRID of the column, 0 if none
+     */
+    wkb_decoder(std::string name, int32_t srid, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Check the SRID of a value against the column's
+     */
+    arrow::Status check_srid(int32_t srid) const;
+
+    std::string name_;
+    int32_t srid_;
+    std::shared_ptr<arrow::DataType> type_;
+    arrow::TypedBufferBuilder<int32_t> offsets_;
+    arrow::BufferBuilder data_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a point, lseg, box, path, polygon, line or
+ *        circle column
+ */
+arrow::Status make_geometry_decoder(const column_spec& spec, arrow::MemoryPool* pool,
+                                    std::unique_ptr<column_decoder>* out);
+
+/**
+ * @brief Create the decoder for a PostGIS geometry or geography column,
+ *        whose SRID is taken from the spec's typmod
+ */
+arrow::Status make_postgis_decoder(const column_spec& spec, arrow::MemoryPool* pool,
+                                   std::unique_ptr<column_decoder>* out);
+
+}
@@ -0,0 +1,146 @@
+#include "hstore_decoder.h"
+
+#include <limits>
+
+namespace pgarrow {
+
+hstore_decoder::hstore_decoder(std::string name, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    offsets_(pool),
+    validity_(pool),
+    key_offsets_(pool),
+    keys_(pool),
+    value_offsets_(pool),
+    values_(pool),
+    value_validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> hstore_decoder::type() const
+{
+    return arrow::map(arrow::utf8(), arrow::utf8());
+}
+
+arrow::Status hstore_decoder::append(const char* data, int32_t length)
+{
+    constexpr int64_t max_offset = std::numeric_limits<int32_t>::max();
+    if (length < HSTORE_HEADER_SIZE) {
+        return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+    }
+    int32_t const count = unpack_int32(data);
+    const char* pos = data + HSTORE_HEADER_SIZE;
+    const char* const end = data + length;
+    // every pair takes at least its two length words
+    if (count < 0 || count > (end - pos) / 8) {
+        return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+    }
+    if (value_validity_.length() + count > max_offset) {
+        return arrow::Status::CapacityError("more than 2^31 hstore pairs in one batch of column '", name_,
+                                            "', use smaller batches");
+    }
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(append_offset());
+    }
+    ARROW_RETURN_NOT_OK(key_offsets_.Reserve(count));
+    ARROW_RETURN_NOT_OK(value_offsets_.Reserve(count));
+    ARROW_RETURN_NOT_OK(value_validity_.reserve(count));
+    for (int32_t i = 0; i < count; ++i) {
+        if (end - pos < 4) {
+            return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+        }
+        int32_t const key_length = unpack_int32(pos);
+        pos += 4;
+        if (key_length < 0 || end - pos < int64_t(key_length) + 4) {
+            return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+        }
+        if (keys_.length() + key_length > max_offset) {
+            return arrow::Status::CapacityError("more than 2 GB of hstore keys in one batch of column '", name_,
+                                                "', use smaller batches");
+        }
+        ARROW_RETURN_NOT_OK(keys_.Append(pos, key_length));
+        key_offsets_.UnsafeAppend(static_cast<int32_t>(keys_.length()));
+        pos += key_length;
+
+        int32_t const value_length = unpack_int32(pos);
+        pos += 4;
+        if (value_length == -1) {
+            value_offsets_.UnsafeAppend(static_cast<int32_t>(values_.length()));
+            ARROW_RETURN_NOT_OK(value_validity_.append_null());
+            continue;
+        }
+        if (value_length < 0 || end - pos < value_length) {
+            return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+        }
+        if (values_.length() + value_length > max_offset) {
+            return arrow::Status::CapacityError("more than 2 GB of hstore values in one batch of column '", name_,
+                                                "', use smaller batches");
+        }
+        ARROW_RETURN_NOT_OK(values_.Append(pos, value_length));
+        value_offsets_.UnsafeAppend(static_cast<int32_t>(values_.length()));
+        ARROW_RETURN_NOT_OK(value_validity_.append_valid());
+        pos += value_length;
+    }
+    if (pos != end) {
+        return arrow::Status::Invalid("corrupt hstore field in column '", name_, "'");
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(value_validity_.length())));
+    return validity_.append_valid();
+}
+
+arrow::Status hstore_decoder::append_null()
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(append_offset());
+    }
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(value_validity_.length())));
+    return validity_.append_null();
+}
+
+arrow::Status hstore_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(validity_.reserve(n));
+    return offsets_.Reserve(n + 1);
+}
+
+arrow::Status hstore_decoder::append_offset()
+{
+    ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    if (key_offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(key_offsets_.Append(0));
+        ARROW_RETURN_NOT_OK(value_offsets_.Append(0));
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status hstore_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(append_offset());
+    }
+    int64_t const length = offsets_.length() - 1;
+    int64_t const null_count = validity_.null_count();
+    int64_t const pairs = value_validity_.length();
+    int64_t const value_null_count = value_validity_.null_count();
+    std::shared_ptr<arrow::Buffer> offsets, validity, key_offsets, keys, value_offsets, values, value_validity;
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(key_offsets_.Finish(&key_offsets));
+    ARROW_RETURN_NOT_OK(keys_.Finish(&keys));
+    ARROW_RETURN_NOT_OK(value_offsets_.Finish(&value_offsets));
+    ARROW_RETURN_NOT_OK(values_.Finish(&values));
+    ARROW_RETURN_NOT_OK(value_validity_.finish(&value_validity));
+
+    auto const map_type = type();
+    auto const entries_type = map_type->field(0)->type();
+    auto entries = arrow::ArrayData::Make(entries_type, pairs, {nullptr}, 0);
+    entries->child_data.push_back(arrow::ArrayData::Make(arrow::utf8(), pairs, {nullptr, key_offsets, keys}, 0));
+    entries->child_data.push_back(arrow::ArrayData::Make(arrow::utf8(), pairs,
+                                                         {value_validity, value_offsets, values},
+                                                         value_null_count));
+    auto array = arrow::ArrayData::Make(map_type, length, {validity, offsets}, null_count);
+    array->child_data.push_back(std::move(entries));
+    *out = arrow::MakeArray(std::move(array));
+    return arrow::Status::OK();
+}
+
+}
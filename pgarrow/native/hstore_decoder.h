@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of hstore in the send format (see hstore_send in PG's
+ * contrib/hstore/hstore_io.c): int32 number of pairs, then per pair the
+ * key as a length word and its text, and the value likewise, with a length
+ * of -1 for NULL values.
+ */
+constexpr int32_t HSTORE_HEADER_SIZE = 4;
+
+/**
+ * @brief Decoder for hstore columns into map<utf8, utf8> arrays.
+ *
+ * Keys and values are copied straight into the data buffers of the key and
+ * item children as the pairs are read, with their offsets, the validity of
+ * the values and the offsets of the map written in the same pass; no
+ * per row or per pair object is built.
+ */
+class hstore_decoder : public column_decoder {
+  public:
+    hstore_decoder(std::string name, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Append the offset of the next map, and of the next key and
+     *        value if it is the first
+     */
+    arrow::Status append_offset();
+
+    std::string name_;
+    arrow::TypedBufferBuilder<int32_t> offsets_;
+    validity_bitmap validity_;
+    arrow::TypedBufferBuilder<int32_t> key_offsets_;
+    arrow::BufferBuilder keys_;
+    arrow::TypedBufferBuilder<int32_t> value_offsets_;
+    arrow::BufferBuilder values_;
+    validity_bitmap value_validity_;
+};
+
+}
@@ -0,0 +1,102 @@
+#include "json_decoder.h"
+
+#include <algorithm>
+
+#include <arrow/json/options.h>
+#include <arrow/json/reader.h>
+
+namespace pgarrow {
+
+json_struct_decoder::json_struct_decoder(std::string name, bool jsonb, std::shared_ptr<arrow::DataType> type,
+                                         arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    jsonb_(jsonb),
+    type_(std::move(type)),
+    pool_(pool),
+    lines_(pool),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> json_struct_decoder::type() const
+{
+    return type_ ? type_ : arrow::struct_({});
+}
+
+arrow::Status json_struct_decoder::append(const char* data, int32_t length)
+{
+    if (jsonb_) {
+        if (length < 1 || static_cast<uint8_t>(data[0]) != JSONB_VERSION) {
+            return arrow::Status::Invalid("unsupported jsonb version in column '", name_, "'");
+        }
+        ++data;
+        --length;
+    }
+    ARROW_RETURN_NOT_OK(lines_.Reserve(length + 1));
+    // line breaks can only be whitespace between tokens, JSON strings escape them
+    auto* line = lines_.mutable_data() + lines_.length();
+    std::replace_copy_if(data, data + length, reinterpret_cast<char*>(line),
+                         [](char c) { return c == '\n' || c == '\r'; }, ' ');
+    line[length] = '\n';
+    lines_.UnsafeAdvance(length + 1);
+    return validity_.append_valid();
+}
+
+arrow::Status json_struct_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(lines_.Append("{}\n", 3));
+    return validity_.append_null();
+}
+
+arrow::Status json_struct_decoder::reserve(int64_t n)
+{
+    return validity_.reserve(n);
+}
+
+arrow::Status json_struct_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Buffer> validity;
+    std::shared_ptr<arrow::Buffer> lines;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    ARROW_RETURN_NOT_OK(lines_.Finish(&lines));
+    if (!type_ && null_count == length) {
+        // nothing to infer the type from yet, copy_decoder::make_table
+        // gives these NULLs the type of the following batches
+        ARROW_ASSIGN_OR_RAISE(*out, arrow::MakeArrayOfNull(type(), length, pool_));
+        return arrow::Status::OK();
+    }
+    if (length == 0) {
+        ARROW_ASSIGN_OR_RAISE(*out, arrow::MakeEmptyArray(type(), pool_));
+        return arrow::Status::OK();
+    }
+
+    auto options = arrow::json::ParseOptions::Defaults();
+    if (type_) {
+        options.explicit_schema = arrow::schema(type_->fields());
+        options.unexpected_field_behavior = arrow::json::UnexpectedFieldBehavior::Ignore;
+    }
+    auto parsed = arrow::json::ParseOne(options, lines);
+    if (!parsed.ok()) {
+        return parsed.status().WithMessage("invalid JSON object in column '", name_, "': ",
+                                           parsed.status().message());
+    }
+    auto const batch = parsed.MoveValueUnsafe();
+    if (!type_) {
+        type_ = arrow::struct_(batch->schema()->fields());
+    }
+
+    auto array = arrow::ArrayData::Make(type_, length, {validity}, null_count);
+    for (auto const& field : type_->fields()) {
+        auto child = batch->GetColumnByName(field->name());
+        if (!child) {
+            ARROW_ASSIGN_OR_RAISE(child, arrow::MakeArrayOfNull(field->type(), length, pool_));
+        }
+        array->child_data.push_back(child->data());
+    }
+    *out = arrow::MakeArray(std::move(array));
+    return arrow::Status::OK();
+}
+
+}
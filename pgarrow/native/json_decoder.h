@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of jsonb in the send format (see jsonb_send in PG's
+ * utils/adt/jsonb.c): a uint8 version, 1, then the value as JSON text.
+ * json is sent as its text alone.
+ */
+constexpr uint8_t JSONB_VERSION = 1;
+
+/**
+ * @brief Decoder for jsonb columns into the arrays of the text decoder it
+ *        wraps (utf8, large_utf8 or utf8_view).
+ *
+ * The version byte is checked and skipped, and the JSON text after it goes
+ * to the text decoder as is, so it is copied (or referenced, for utf8_view)
+ * like any text value without being parsed.
+ */
+class jsonb_decoder : public column_decoder {
+  public:
+    jsonb_decoder(std::string name, std::unique_ptr<column_decoder> text) :
+        name_(std::move(name)),
+        text_(std::move(text))
+    {
+    }
+
+    std::shared_ptr<arrow::DataType> type() const override { return text_->type(); }
+
+    arrow::Status append(const char* data, int32_t length) override
+    {
+        if (length < 1 || static_cast<uint8_t>(data[0]) != JSONB_VERSION) {
+            return arrow::Status::Invalid("unsupported jsonb version in column '", name_, "'");
+        }
+        return text_->append(data + 1, length - 1);
+    }
+
+    arrow::Status append_null() override { return text_->append_null(); }
+    arrow::Status reserve(int64_t n) override { return text_->reserve(n); }
+    void set_source(std::shared_ptr<arrow::Buffer> source) override { text_->set_source(std::move(source)); }
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override { return text_->finish(out); }
+
+  private:
+    std::string name_;
+    std::unique_ptr<column_decoder> text_;
+};
+
+/**
+ * @brief Decoder for json and jsonb columns holding objects into struct
+ *        arrays, one child per key.
+ *
+ * The values of a batch are gathered as newline-delimited JSON, NULLs as
+ * empty objects, and parsed in one go by Arrow's JSON parser when the batch
+ * is finished. The struct type is given, in which case keys not in it are
+ * ignored and keys missing from a value are NULL, or inferred from the first
+ * batch holding values and kept for the following ones; batches of NULLs
+ * before it are struct<>. Values other than objects fail the decode.
+ */
+class json_struct_decoder : public column_decoder {
+  public:
+    json_struct_decoder(std::string name, bool jsonb, std::shared_ptr<arrow::DataType> type,
+                        arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    std::string name_;
+    bool jsonb_;
+    // nullptr until inferred from the first batch holding values
+    std::shared_ptr<arrow::DataType> type_;
+    arrow::MemoryPool* pool_;
+    arrow::BufferBuilder lines_;
+    validity_bitmap validity_;
+};
+
+}
@@ -0,0 +1,106 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pgarrow {
+
+mapped_file::mapped_file(const uint8_t* data, int64_t size) :
+    arrow::Buffer(data, size)
+{
+}
+
+#if defined(_WIN32)
+
+arrow::Status mapped_file::open(const std::string& path, std::shared_ptr<mapped_file>*)
+{
+    return arrow::Status::NotImplemented("memory mapped reading is not supported on this platform");
+}
+
+mapped_file::~mapped_file()
+{
+}
+
+void mapped_file::prefetch(int64_t, int64_t) const
+{
+}
+
+#else
+
+arrow::Status mapped_file::open(const std::string& path, std::shared_ptr<mapped_file>* out)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return arrow::Status::IOError("failed to open '", path, "': ", std::strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1) {
+        int error = errno;
+        ::close(fd);
+        return arrow::Status::IOError("failed to stat '", path, "': ", std::strerror(error));
+    }
+
+    void* data = nullptr;
+    if (st.st_size > 0) {
+        data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            return arrow::Status::IOError("failed to map '", path, "': ", std::strerror(error));
+        }
+        ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd, 0, st.st_size, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    out->reset(new mapped_file(static_cast<const uint8_t*>(data), st.st_size));
+    return arrow::Status::OK();
+}
+
+mapped_file::~mapped_file()
+{
+    if (size_ > 0) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+void mapped_file::prefetch(int64_t offset, int64_t length) const
+{
+    static const int64_t page_size = ::sysconf(_SC_PAGESIZE);
+    offset = std::max<int64_t>(offset, 0);
+    length = std::min(length, size_ - offset);
+    if (length <= 0) {
+        return;
+    }
+    // madvise wants a page aligned start address
+    int64_t aligned = offset - offset % page_size;
+    ::madvise(const_cast<uint8_t*>(data_) + aligned, length + (offset - aligned), MADV_WILLNEED);
+}
+
+#endif
+
+arrow::Status decode_mapped_file(copy_decoder* decoder, const std::shared_ptr<mapped_file>& file,
+                                 std::shared_ptr<arrow::Table>* out)
+{
+    auto const data = reinterpret_cast<const char*>(file->data());
+    decoder->set_source(file);
+    // ranges are decoded in order (or one per thread), so ask for each
+    // range and the one after it
+    return decoder->decode_table(data, file->size(), out, [&file](int64_t offset, int64_t length) {
+        file->prefetch(offset, 2 * length);
+    });
+}
+
+}
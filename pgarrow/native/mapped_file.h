@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "copy_decoder.h"
+
+namespace pgarrow {
+
+/**
+ * @brief Read-only memory mapping of a whole file (e.g. a saved .pgdat COPY
+ *        dump), exposed as an Arrow buffer that unmaps the file when the
+ *        last reference goes away.
+ *
+ * The mapping is advised as sequential so the kernel reads ahead
+ * aggressively and drops pages behind the reader; prefetch() can be used
+ * to ask for a window ahead of the current position explicitly.
+ */
+class mapped_file : public arrow::Buffer {
+  public:
+    static arrow::Status open(const std::string& path, std::shared_ptr<mapped_file>* out);
+
+    ~mapped_file() override;
+
+    /**
+     * @brief Ask the kernel to start reading [offset, offset + length) into
+     *        the page cache without waiting for it
+     */
+    void prefetch(int64_t offset, int64_t length) const;
+
+  private:
+    mapped_file(const uint8_t* data, int64_t size);
+};
+
+/**
+ * @brief Decode a mapped COPY BINARY file, prefetching each range of it
+ *        (and the next one) as the decoder gets to it. The file is the
+ *        decoder's source, so string views keep the mapping alive.
+ */
+arrow::Status decode_mapped_file(copy_decoder* decoder, const std::shared_ptr<mapped_file>& file,
+                                 std::shared_ptr<arrow::Table>* out);
+
+}
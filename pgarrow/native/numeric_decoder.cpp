@@ -0,0 +1,43 @@
+#include "numeric_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+// typmods carry a 4 byte header length (VARHDRSZ) on top of their value
+constexpr int32_t VARHDRSZ = 4;
+
+// widest decimal Arrow has
+constexpr int32_t DECIMAL256_MAX_PRECISION = 76;
+
+}
+
+arrow::Status make_numeric_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                   std::unique_ptr<column_decoder>* out)
+{
+    int32_t precision = types.numeric_precision;
+    int32_t scale = types.numeric_scale;
+    if (spec.typmod >= VARHDRSZ) {
+        precision = ((spec.typmod - VARHDRSZ) >> 16) & 0xffff;
+        // 11 bit two's complement, negative since PG 15
+        scale = (((spec.typmod - VARHDRSZ) & 0x7ff) ^ 1024) - 1024;
+    }
+    if (scale < 0) {
+        return arrow::Status::NotImplemented("numeric column '", spec.name, "' has negative scale ", scale);
+    }
+    // wider numerics only fit while their values are small enough
+    precision = std::min(precision, DECIMAL256_MAX_PRECISION);
+
+    if (precision <= arrow::Decimal128Type::kMaxPrecision) {
+        ARROW_ASSIGN_OR_RAISE(auto type, arrow::Decimal128Type::Make(precision, scale));
+        out->reset(new numeric_decoder<arrow::Decimal128>(type, spec.name, types.numeric_overflow,
+                                                          types.numeric_special, pool));
+    } else {
+        ARROW_ASSIGN_OR_RAISE(auto type, arrow::Decimal256Type::Make(precision, scale));
+        out->reset(new numeric_decoder<arrow::Decimal256>(type, spec.name, types.numeric_overflow,
+                                                          types.numeric_special, pool));
+    }
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+#include <arrow/util/decimal.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of numeric in the send format (see numeric_send in PG's
+ * utils/adt/numeric.c): four int16 words ndigits, weight, sign and dscale,
+ * then ndigits base-10000 digits, the first of which is worth
+ * 10000^weight. Leading and trailing zero digits are not sent.
+ */
+constexpr int32_t NUMERIC_HEADER_SIZE = 8;
+constexpr uint16_t NUMERIC_POS = 0x0000;
+constexpr uint16_t NUMERIC_NEG = 0x4000;
+constexpr uint16_t NUMERIC_NAN = 0xC000;
+constexpr uint16_t NUMERIC_PINF = 0xD000;
+constexpr uint16_t NUMERIC_NINF = 0xF000;
+
+/**
+ * @brief Outcome of converting one numeric to a decimal
+ */
+enum class numeric_result {
+    ok,
+    /// more integer digits than the precision leaves room for
+    overflow,
+    /// NaN or +-Infinity, which decimals cannot hold
+    special,
+    /// field inconsistent with the numeric layout
+    invalid
+};
+
+/**
+ * @brief Convert a numeric field to an unscaled decimal at `scale`, rounding
+ *        half away from zero like PG where the field has more fraction
+ *        digits.
+ *
+ * Digits are accumulated into the unscaled integer from the most
+ * significant down, four decimal digits at a time. Numerics whose unscaled
+ * value has at most 18 digits (most amounts and measurements) are summed
+ * in a plain uint64_t; longer ones in the Decimal type itself, checking
+ * before every step that it stays below 10^precision.
+ */
+template <typename Decimal>
+numeric_result convert_numeric(const char* data, int32_t length, int32_t precision, int32_t scale,
+                               Decimal* out)
+{
+    static const uint64_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+                                     1000000000, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+                                     10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+                                     10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL};
+    if (length < NUMERIC_HEADER_SIZE) {
+        return numeric_result::invalid;
+    }
+    int32_t const ndigits = unpack_int16(data);
+    int32_t const weight = unpack_int16(data + 2);
+    auto const sign = static_cast<uint16_t>(unpack_int16(data + 4));
+    if (ndigits < 0 || length != NUMERIC_HEADER_SIZE + 2 * ndigits) {
+        return numeric_result::invalid;
+    }
+    if (sign == NUMERIC_NAN || sign == NUMERIC_PINF || sign == NUMERIC_NINF) {
+        return numeric_result::special;
+    }
+    if (sign != NUMERIC_POS && sign != NUMERIC_NEG) {
+        return numeric_result::invalid;
+    }
+
+    const char* digits = data + NUMERIC_HEADER_SIZE;
+    // base-10000 digit worth 10000^g
+    auto digit = [&](int32_t g) -> int32_t {
+        int32_t const i = weight - g;
+        return (i >= 0 && i < ndigits) ? unpack_int16(digits + 2 * i) : 0;
+    };
+
+    int32_t const full_groups = scale / 4;
+    int32_t const partial = scale % 4;
+    // the digit group holding the first digit below the scale
+    int32_t const last = digit(-full_groups - 1);
+    int32_t const kept = partial ? last / static_cast<int32_t>(POW10[4 - partial]) : 0;
+    int32_t const dropped = partial ? last % static_cast<int32_t>(POW10[4 - partial]) : last;
+    bool const round_up = dropped >= 5 * static_cast<int32_t>(POW10[3 - partial]);
+
+    if (4 * std::max(weight + 1, 0) + scale <= 18) {
+        uint64_t acc = 0;
+        for (int32_t g = weight; g >= -full_groups; --g) {
+            acc = acc * 10000 + digit(g);
+        }
+        acc = acc * POW10[partial] + kept + (round_up ? 1 : 0);
+        if (precision <= 18 && acc >= POW10[precision]) {
+            return numeric_result::overflow;
+        }
+        *out = Decimal(static_cast<int64_t>(acc));
+    } else {
+        Decimal acc;
+        auto step = [&](int32_t m, int32_t d) {
+            // acc * 10^m + d stays below 10^precision only if this holds
+            if (acc >= Decimal::GetScaleMultiplier(std::max(precision - m, 0))) {
+                return false;
+            }
+            acc *= Decimal::GetScaleMultiplier(m);
+            acc += Decimal(d);
+            return true;
+        };
+        for (int32_t g = weight; g >= -full_groups; --g) {
+            if (!step(4, digit(g))) {
+                return numeric_result::overflow;
+            }
+        }
+        if (!step(partial, kept)) {
+            return numeric_result::overflow;
+        }
+        if (round_up) {
+            acc += Decimal(1);
+        }
+        if (acc >= Decimal::GetScaleMultiplier(precision)) {
+            return numeric_result::overflow;
+        }
+        *out = acc;
+    }
+    if (sign == NUMERIC_NEG) {
+        out->Negate();
+    }
+    return numeric_result::ok;
+}
+
+/**
+ * @brief Decoder for numeric columns into decimal128 (precision up to 38)
+ *        or decimal256 arrays.
+ *
+ * Values that do not fit the precision, and NaN and +-Infinity, either
+ * fail the decode or become NULL, as set by the column's policies.
+ */
+template <typename Decimal>
+class numeric_decoder : public column_decoder {
+  public:
+    numeric_decoder(std::shared_ptr<arrow::DataType> type, std::string name, value_policy overflow,
+                    value_policy special, arrow::MemoryPool* pool) :
+        type_(std::move(type)),
+        name_(std::move(name)),
+        precision_(static_cast<const arrow::DecimalType&>(*type_).precision()),
+        scale_(static_cast<const arrow::DecimalType&>(*type_).scale()),
+        overflow_(overflow),
+        special_(special),
+        values_(pool),
+        validity_(pool)
+    {
+    }
+
+    std::shared_ptr<arrow::DataType> type() const override { return type_; }
+
+    arrow::Status append(const char* data, int32_t length) override
+    {
+        Decimal value;
+        switch (convert_numeric(data, length, precision_, scale_, &value)) {
+            case numeric_result::ok:
+                break;
+            case numeric_result::overflow:
+                if (overflow_ == value_policy::null) {
+                    return append_null();
+                }
+                return arrow::Status::Invalid("numeric value does not fit ", type_->ToString(),
+                                              " in column '", name_, "'");
+            case numeric_result::special:
+                if (special_ == value_policy::null) {
+                    return append_null();
+                }
+                return arrow::Status::Invalid("NaN or Infinity in numeric column '", name_, "'");
+            case numeric_result::invalid:
+                return arrow::Status::Invalid("corrupt numeric field of ", length, " bytes in column '",
+                                              name_, "'");
+        }
+        ARROW_RETURN_NOT_OK(validity_.append_valid());
+        ARROW_RETURN_NOT_OK(values_.Reserve(WIDTH));
+        value.ToBytes(values_.mutable_data() + values_.length());
+        values_.UnsafeAdvance(WIDTH);
+        return arrow::Status::OK();
+    }
+
+    arrow::Status append_null() override
+    {
+        ARROW_RETURN_NOT_OK(validity_.append_null());
+        return values_.Append(WIDTH, 0);
+    }
+
+    arrow::Status reserve(int64_t n) override
+    {
+        ARROW_RETURN_NOT_OK(validity_.reserve(n));
+        return values_.Reserve(n * WIDTH);
+    }
+
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override
+    {
+        int64_t const length = validity_.length();
+        int64_t const null_count = validity_.null_count();
+        std::shared_ptr<arrow::Buffer> validity;
+        std::shared_ptr<arrow::Buffer> values;
+        ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+        ARROW_RETURN_NOT_OK(values_.Finish(&values));
+        *out = arrow::MakeArray(arrow::ArrayData::Make(type_, length, {validity, values}, null_count));
+        return arrow::Status::OK();
+    }
+
+  private:
+    static constexpr int64_t WIDTH = sizeof(Decimal);
+
+    std::shared_ptr<arrow::DataType> type_;
+    std::string name_;
+    int32_t precision_;
+    int32_t scale_;
+    value_policy overflow_;
+    value_policy special_;
+    arrow::BufferBuilder values_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a numeric column. The precision and scale
+ *        come from the typmod, or from `types` for unconstrained columns.
+ */
+arrow::Status make_numeric_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                   std::unique_ptr<column_decoder>* out);
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pgarrow {
+
+/**
+ * @brief Builtin type OIDs understood by the native decoder.
+ *        Values match pg_catalog.pg_type (see protocol/pgtypes.pxi)
+ */
+constexpr uint32_t BOOLOID = 16;
+constexpr uint32_t BYTEAOID = 17;
+constexpr uint32_t NAMEOID = 19;
+constexpr uint32_t INT8OID = 20;
+constexpr uint32_t INT2OID = 21;
+constexpr uint32_t INT4OID = 23;
+constexpr uint32_t TEXTOID = 25;
+constexpr uint32_t TIDOID = 27;
+constexpr uint32_t JSONOID = 114;
+constexpr uint32_t POINTOID = 600;
+constexpr uint32_t LSEGOID = 601;
+constexpr uint32_t PATHOID = 602;
+constexpr uint32_t BOXOID = 603;
+constexpr uint32_t POLYGONOID = 604;
+constexpr uint32_t LINEOID = 628;
+constexpr uint32_t CIDROID = 650;
+constexpr uint32_t FLOAT4OID = 700;
+constexpr uint32_t FLOAT8OID = 701;
+constexpr uint32_t CIRCLEOID = 718;
+constexpr uint32_t MACADDR8OID = 774;
+constexpr uint32_t MACADDROID = 829;
+constexpr uint32_t INETOID = 869;
+constexpr uint32_t BPCHAROID = 1042;
+constexpr uint32_t VARCHAROID = 1043;
+constexpr uint32_t DATEOID = 1082;
+constexpr uint32_t TIMEOID = 1083;
+constexpr uint32_t TIMESTAMPOID = 1114;
+constexpr uint32_t TIMESTAMPTZOID = 1184;
+constexpr uint32_t INTERVALOID = 1186;
+constexpr uint32_t BITOID = 1560;
+constexpr uint32_t VARBITOID = 1562;
+constexpr uint32_t NUMERICOID = 1700;
+constexpr uint32_t UUIDOID = 2950;
+constexpr uint32_t JSONBOID = 3802;
+
+/** @brief Microseconds between the Unix epoch and the PG epoch (2000-01-01) */
+constexpr int64_t PG_EPOCH_OFFSET_USECS = 946684800000000LL;
+
+/** @brief Days between the Unix epoch and the PG epoch */
+constexpr int32_t PG_EPOCH_OFFSET_DAYS = 10957;
+
+}
@@ -0,0 +1,132 @@
+#include "range_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+arrow::FieldVector range_fields(const std::shared_ptr<arrow::DataType>& subtype)
+{
+    return {arrow::field("lower", subtype), arrow::field("upper", subtype),
+            arrow::field("lower_inclusive", arrow::boolean(), false),
+            arrow::field("upper_inclusive", arrow::boolean(), false), arrow::field("empty", arrow::boolean(), false)};
+}
+
+}
+
+range_decoder::range_decoder(std::string name, std::unique_ptr<column_decoder> lower,
+                             std::unique_ptr<column_decoder> upper, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    lower_(std::move(lower)),
+    upper_(std::move(upper)),
+    lower_inclusive_(pool),
+    upper_inclusive_(pool),
+    empty_(pool),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> range_decoder::type() const
+{
+    return arrow::struct_(range_fields(lower_->type()));
+}
+
+arrow::Status range_decoder::append_bound(column_decoder* bound, const char** pos, const char* end)
+{
+    if (end - *pos < 4) {
+        return arrow::Status::Invalid("corrupt range field in column '", name_, "'");
+    }
+    int32_t const length = unpack_int32(*pos);
+    *pos += 4;
+    if (length < 0 || end - *pos < length) {
+        return arrow::Status::Invalid("corrupt range field in column '", name_, "'");
+    }
+    ARROW_RETURN_NOT_OK(bound->append(*pos, length));
+    *pos += length;
+    return arrow::Status::OK();
+}
+
+arrow::Status range_decoder::append(const char* data, int32_t length)
+{
+    if (length < 1) {
+        return arrow::Status::Invalid("corrupt range field in column '", name_, "'");
+    }
+    auto const flags = static_cast<uint8_t>(data[0]);
+    const char* pos = data + 1;
+    const char* const end = data + length;
+    bool const empty = flags & RANGE_EMPTY;
+    if (empty || (flags & RANGE_LB_INF)) {
+        ARROW_RETURN_NOT_OK(lower_->append_null());
+    } else {
+        ARROW_RETURN_NOT_OK(append_bound(lower_.get(), &pos, end));
+    }
+    if (empty || (flags & RANGE_UB_INF)) {
+        ARROW_RETURN_NOT_OK(upper_->append_null());
+    } else {
+        ARROW_RETURN_NOT_OK(append_bound(upper_.get(), &pos, end));
+    }
+    if (pos != end) {
+        return arrow::Status::Invalid("corrupt range field in column '", name_, "'");
+    }
+    ARROW_RETURN_NOT_OK(lower_inclusive_.Append((flags & RANGE_LB_INC) != 0));
+    ARROW_RETURN_NOT_OK(upper_inclusive_.Append((flags & RANGE_UB_INC) != 0));
+    ARROW_RETURN_NOT_OK(empty_.Append(empty));
+    return validity_.append_valid();
+}
+
+arrow::Status range_decoder::append_null()
+{
+    ARROW_RETURN_NOT_OK(lower_->append_null());
+    ARROW_RETURN_NOT_OK(upper_->append_null());
+    ARROW_RETURN_NOT_OK(lower_inclusive_.Append(false));
+    ARROW_RETURN_NOT_OK(upper_inclusive_.Append(false));
+    ARROW_RETURN_NOT_OK(empty_.Append(false));
+    return validity_.append_null();
+}
+
+arrow::Status range_decoder::reserve(int64_t n)
+{
+    ARROW_RETURN_NOT_OK(lower_->reserve(n));
+    ARROW_RETURN_NOT_OK(upper_->reserve(n));
+    ARROW_RETURN_NOT_OK(lower_inclusive_.Reserve(n));
+    ARROW_RETURN_NOT_OK(upper_inclusive_.Reserve(n));
+    ARROW_RETURN_NOT_OK(empty_.Reserve(n));
+    return validity_.reserve(n);
+}
+
+arrow::Status range_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    std::shared_ptr<arrow::Array> lower;
+    std::shared_ptr<arrow::Array> upper;
+    ARROW_RETURN_NOT_OK(lower_->finish(&lower));
+    ARROW_RETURN_NOT_OK(upper_->finish(&upper));
+    std::vector<std::shared_ptr<arrow::ArrayData>> children = {lower->data(), upper->data()};
+    for (auto* flags : {&lower_inclusive_, &upper_inclusive_, &empty_}) {
+        std::shared_ptr<arrow::Buffer> values;
+        ARROW_RETURN_NOT_OK(flags->Finish(&values));
+        children.push_back(arrow::ArrayData::Make(arrow::boolean(), length, {nullptr, values}, 0));
+    }
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    *out = arrow::MakeArray(arrow::ArrayData::Make(arrow::struct_(range_fields(lower->type())), length, {validity},
+                                                   std::move(children), null_count));
+    return arrow::Status::OK();
+}
+
+arrow::Status make_range_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                 std::unique_ptr<column_decoder>* out)
+{
+    if (spec.children.size() != 1) {
+        return arrow::Status::Invalid("range column '", spec.name, "' needs one subtype, got ",
+                                      spec.children.size());
+    }
+    std::unique_ptr<column_decoder> lower;
+    std::unique_ptr<column_decoder> upper;
+    ARROW_RETURN_NOT_OK(make_column_decoder(spec.children.front(), types, pool, &lower));
+    ARROW_RETURN_NOT_OK(make_column_decoder(spec.children.front(), types, pool, &upper));
+    out->reset(new range_decoder(spec.name, std::move(lower), std::move(upper), pool));
+    return arrow::Status::OK();
+}
+
+}
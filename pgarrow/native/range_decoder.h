@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of ranges in the send format (see range_send in PG's
+ * utils/adt/rangetypes.c): a flags byte, then unless the range is empty
+ * the lower bound and the upper bound, each as a length word and the
+ * subtype's send format, left out when the bound is infinite.
+ */
+constexpr uint8_t RANGE_EMPTY = 0x01;
+constexpr uint8_t RANGE_LB_INC = 0x02;
+constexpr uint8_t RANGE_UB_INC = 0x04;
+constexpr uint8_t RANGE_LB_INF = 0x08;
+constexpr uint8_t RANGE_UB_INF = 0x10;
+
+/**
+ * @brief Decoder for range columns into struct<lower, upper,
+ *        lower_inclusive, upper_inclusive, empty> arrays.
+ *
+ * The bounds are decoded by two decoders of the subtype, so they land in
+ * its Arrow type through the same kernels as plain columns of it. Infinite
+ * bounds, and both bounds of empty ranges, are NULL, as lower() and
+ * upper() return them in PG.
+ */
+class range_decoder : public column_decoder {
+  public:
+    range_decoder(std::string name, std::unique_ptr<column_decoder> lower, std::unique_ptr<column_decoder> upper,
+                  arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    /**
+     * @brief Append the bound at `*pos`, moving past it
+     */
+    arrow::Status append_bound(column_decoder* bound, const char** pos, const char* end);
+
+    std::string name_;
+    std::unique_ptr<column_decoder> lower_;
+    std::unique_ptr<column_decoder> upper_;
+    arrow::TypedBufferBuilder<bool> lower_inclusive_;
+    arrow::TypedBufferBuilder<bool> upper_inclusive_;
+    arrow::TypedBufferBuilder<bool> empty_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a range column, whose subtype is described
+ *        by the spec's only child
+ */
+arrow::Status make_range_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                 std::unique_ptr<column_decoder>* out);
+
+}
@@ -0,0 +1,126 @@
+#include "string_dictionary.h"
+
+#include <cstring>
+#include <limits>
+
+namespace pgarrow {
+
+namespace {
+
+constexpr std::size_t INITIAL_SLOTS = 1 << 10;
+
+}
+
+string_dictionary::string_dictionary(arrow::MemoryPool* pool) :
+    offsets_(pool),
+    data_(pool),
+    size_(0)
+{
+    reset();
+}
+
+uint32_t string_dictionary::hash(const char* data, int32_t length)
+{
+    uint64_t constexpr multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = static_cast<uint64_t>(length) * multiplier;
+    int32_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * multiplier;
+        h ^= h >> 29;
+    }
+    if (i < length) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, length - i);
+        h = (h ^ word) * multiplier;
+        h ^= h >> 29;
+    }
+    return static_cast<uint32_t>(h >> 32);
+}
+
+void string_dictionary::reset()
+{
+    slots_.assign(INITIAL_SLOTS, slot{0, EMPTY});
+    offsets_.Reset();
+    data_.Reset();
+    size_ = 0;
+}
+
+void string_dictionary::grow()
+{
+    std::vector<slot> slots(slots_.size() * 2, slot{0, EMPTY});
+    std::size_t const mask = slots.size() - 1;
+    for (auto const& s : slots_) {
+        if (s.index != EMPTY) {
+            std::size_t i = s.hash & mask;
+            while (slots[i].index != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = s;
+        }
+    }
+    slots_.swap(slots);
+}
+
+int32_t string_dictionary::find(const char* data, int32_t length, uint32_t hash) const
+{
+    std::size_t const mask = slots_.size() - 1;
+    const int32_t* offsets = offsets_.data();
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        slot const& s = slots_[i];
+        if (s.index == EMPTY) {
+            return -1;
+        }
+        if (s.hash == hash && offsets[s.index + 1] - offsets[s.index] == length &&
+            std::memcmp(data_.data() + offsets[s.index], data, length) == 0) {
+            return s.index;
+        }
+    }
+}
+
+arrow::Status string_dictionary::get_or_insert(const char* data, int32_t length, int32_t* index)
+{
+    uint32_t const h = hash(data, length);
+    *index = find(data, length, h);
+    if (*index != -1) {
+        return arrow::Status::OK();
+    }
+
+    if (data_.length() + length > std::numeric_limits<int32_t>::max()) {
+        return arrow::Status::CapacityError("more than 2 GB of distinct values in one dictionary");
+    }
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    *index = size_++;
+    ARROW_RETURN_NOT_OK(data_.Append(data, length));
+    ARROW_RETURN_NOT_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+    // keep at most half of the slots in use
+    if (2 * static_cast<std::size_t>(size_) > slots_.size()) {
+        grow();
+    }
+    std::size_t const mask = slots_.size() - 1;
+    std::size_t i = h & mask;
+    while (slots_[i].index != EMPTY) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = slot{h, *index};
+    return arrow::Status::OK();
+}
+
+arrow::Status string_dictionary::finish(std::shared_ptr<arrow::Array>* out)
+{
+    if (offsets_.length() == 0) {
+        ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    }
+    std::shared_ptr<arrow::Buffer> offsets;
+    std::shared_ptr<arrow::Buffer> data;
+    ARROW_RETURN_NOT_OK(offsets_.Finish(&offsets));
+    ARROW_RETURN_NOT_OK(data_.Finish(&data));
+    *out = arrow::MakeArray(arrow::ArrayData::Make(arrow::utf8(), size_, {nullptr, offsets, data}, 0));
+    reset();
+    return arrow::Status::OK();
+}
+
+}
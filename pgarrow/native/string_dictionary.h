@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <arrow/api.h>
+
+namespace pgarrow {
+
+/**
+ * @brief Distinct strings numbered in order of insertion, with an
+ *        open-addressing hash table (linear probing) to find them.
+ *
+ * Slots hold a 32-bit hash and the index side by side, so most lookups
+ * touch a single cache line before comparing bytes. The strings themselves
+ * are kept as the offsets and data of a utf8 array, which finish() hands
+ * out as the dictionary.
+ */
+class string_dictionary {
+  public:
+    explicit string_dictionary(arrow::MemoryPool* pool);
+
+    int32_t size() const { return size_; }
+
+    /**
+     * @brief Index of a string, or -1 if it is not in the dictionary
+     */
+    int32_t find(const char* data, int32_t length) const { return find(data, length, hash(data, length)); }
+
+    /**
+     * @brief Index of a string, adding it if it is new
+     */
+    arrow::Status get_or_insert(const char* data, int32_t length, int32_t* index);
+
+    /**
+     * @brief Hand out the strings as a utf8 array and start over empty
+     */
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out);
+
+    /**
+     * @brief Drop all strings and shrink the table back to its initial size
+     */
+    void reset();
+
+    /**
+     * @brief Hash a string 8 bytes at a time. Only needs to spread short
+     *        labels well over the slots, not to resist collisions.
+     */
+    static uint32_t hash(const char* data, int32_t length);
+
+  private:
+    struct slot {
+        uint32_t hash;
+        int32_t index;
+    };
+
+    static constexpr int32_t EMPTY = -1;
+
+    int32_t find(const char* data, int32_t length, uint32_t hash) const;
+
+    /**
+     * @brief Double the slots, placing the entries by their stored hash
+     */
+    void grow();
+
+    std::vector<slot> slots_;
+    arrow::TypedBufferBuilder<int32_t> offsets_;
+    arrow::BufferBuilder data_;
+    int32_t size_;
+};
+
+}
@@ -0,0 +1,126 @@
+#include "struct_decoder.h"
+
+namespace pgarrow {
+
+struct_decoder::struct_decoder(std::string name, std::vector<std::string> attribute_names,
+                               std::vector<uint32_t> attribute_oids,
+                               std::vector<std::unique_ptr<column_decoder>> attributes, arrow::MemoryPool* pool) :
+    name_(std::move(name)),
+    attribute_names_(std::move(attribute_names)),
+    attribute_oids_(std::move(attribute_oids)),
+    attributes_(std::move(attributes)),
+    validity_(pool)
+{
+}
+
+std::shared_ptr<arrow::DataType> struct_decoder::type() const
+{
+    arrow::FieldVector fields;
+    for (std::size_t i = 0; i < attributes_.size(); ++i) {
+        fields.push_back(arrow::field(attribute_names_[i], attributes_[i]->type()));
+    }
+    return arrow::struct_(fields);
+}
+
+arrow::Status struct_decoder::corrupt() const
+{
+    return arrow::Status::Invalid("corrupt composite field in column '", name_, "'");
+}
+
+arrow::Status struct_decoder::append(const char* data, int32_t length)
+{
+    if (length < RECORD_HEADER_SIZE) {
+        return corrupt();
+    }
+    int32_t const n_attributes = unpack_int32(data);
+    if (n_attributes != static_cast<int32_t>(attributes_.size())) {
+        return arrow::Status::Invalid("composite of ", n_attributes, " attributes in column '", name_,
+                                      "', expected ", attributes_.size());
+    }
+    const char* pos = data + RECORD_HEADER_SIZE;
+    const char* const end = data + length;
+    for (int32_t i = 0; i < n_attributes; ++i) {
+        if (end - pos < RECORD_ATTRIBUTE_HEADER_SIZE) {
+            return corrupt();
+        }
+        auto const oid = static_cast<uint32_t>(unpack_int32(pos));
+        int32_t const attribute_length = unpack_int32(pos + 4);
+        pos += RECORD_ATTRIBUTE_HEADER_SIZE;
+        if (attribute_oids_[i] != 0 && oid != attribute_oids_[i]) {
+            return arrow::Status::Invalid("attribute '", attribute_names_[i], "' of column '", name_,
+                                          "' has type oid ", oid, ", expected ", attribute_oids_[i]);
+        }
+        if (attribute_length == -1) {
+            ARROW_RETURN_NOT_OK(attributes_[i]->append_null());
+            continue;
+        }
+        if (attribute_length < 0 || end - pos < attribute_length) {
+            return corrupt();
+        }
+        ARROW_RETURN_NOT_OK(attributes_[i]->append(pos, attribute_length));
+        pos += attribute_length;
+    }
+    return validity_.append_valid();
+}
+
+arrow::Status struct_decoder::append_null()
+{
+    for (auto& attribute : attributes_) {
+        ARROW_RETURN_NOT_OK(attribute->append_null());
+    }
+    return validity_.append_null();
+}
+
+arrow::Status struct_decoder::reserve(int64_t n)
+{
+    for (auto& attribute : attributes_) {
+        ARROW_RETURN_NOT_OK(attribute->reserve(n));
+    }
+    return validity_.reserve(n);
+}
+
+void struct_decoder::set_source(std::shared_ptr<arrow::Buffer> source)
+{
+    for (auto& attribute : attributes_) {
+        attribute->set_source(source);
+    }
+}
+
+arrow::Status struct_decoder::finish(std::shared_ptr<arrow::Array>* out)
+{
+    int64_t const length = validity_.length();
+    int64_t const null_count = validity_.null_count();
+    arrow::FieldVector fields;
+    std::vector<std::shared_ptr<arrow::ArrayData>> children;
+    for (std::size_t i = 0; i < attributes_.size(); ++i) {
+        std::shared_ptr<arrow::Array> child;
+        ARROW_RETURN_NOT_OK(attributes_[i]->finish(&child));
+        fields.push_back(arrow::field(attribute_names_[i], child->type()));
+        children.push_back(child->data());
+    }
+    std::shared_ptr<arrow::Buffer> validity;
+    ARROW_RETURN_NOT_OK(validity_.finish(&validity));
+    *out = arrow::MakeArray(arrow::ArrayData::Make(arrow::struct_(fields), length, {validity}, std::move(children),
+                                                   null_count));
+    return arrow::Status::OK();
+}
+
+arrow::Status make_struct_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                  std::unique_ptr<column_decoder>* out)
+{
+    std::vector<std::string> names;
+    std::vector<uint32_t> oids;
+    std::vector<std::unique_ptr<column_decoder>> attributes;
+    for (auto const& child : spec.children) {
+        std::unique_ptr<column_decoder> attribute;
+        ARROW_RETURN_NOT_OK(make_column_decoder(child, types, pool, &attribute));
+        names.push_back(child.name);
+        // enums, composites and pgvector have no fixed oid to check against
+        oids.push_back(child.kind == type_kind::base && child.enum_labels.empty() ? child.oid : 0);
+        attributes.push_back(std::move(attribute));
+    }
+    out->reset(new struct_decoder(spec.name, std::move(names), std::move(oids), std::move(attributes), pool));
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/*
+ * Layout of composites in the send format (see record_send in PG's
+ * utils/adt/rowtypes.c): int32 number of attributes, then per attribute
+ * its type oid, a length word (-1 for NULL) and its own send format.
+ */
+constexpr int32_t RECORD_HEADER_SIZE = 4;
+constexpr int32_t RECORD_ATTRIBUTE_HEADER_SIZE = 8;
+
+/**
+ * @brief Decoder for composite (and anonymous record) columns into struct
+ *        arrays.
+ *
+ * Each attribute has the decoder of its type, made from the spec's
+ * children, which builds the struct's child column; composites, arrays
+ * and the like nest as deep as their specs do. Attributes are appended to
+ * their children as the field is walked, with no intermediate values. A
+ * NULL composite appends a NULL to every child.
+ */
+class struct_decoder : public column_decoder {
+  public:
+    struct_decoder(std::string name, std::vector<std::string> attribute_names, std::vector<uint32_t> attribute_oids,
+                   std::vector<std::unique_ptr<column_decoder>> attributes, arrow::MemoryPool* pool);
+
+    std::shared_ptr<arrow::DataType> type() const override;
+
+    arrow::Status append(const char* data, int32_t length) override;
+    arrow::Status append_null() override;
+    arrow::Status reserve(int64_t n) override;
+    void set_source(std::shared_ptr<arrow::Buffer> source) override;
+    arrow::Status finish(std::shared_ptr<arrow::Array>* out) override;
+
+  private:
+    arrow::Status corrupt() const;
+
+    std::string name_;
+    std::vector<std::string> attribute_names_;
+    // oid each attribute must have, 0 for types without a fixed oid
+    std::vector<uint32_t> attribute_oids_;
+    std::vector<std::unique_ptr<column_decoder>> attributes_;
+    validity_bitmap validity_;
+};
+
+/**
+ * @brief Create the decoder for a composite column, whose attributes are
+ *        described by the spec's children
+ */
+arrow::Status make_struct_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                  std::unique_ptr<column_decoder>* out);
+
+}
@@ -0,0 +1,61 @@
+#include "temporal_decoder.h"
+
+namespace pgarrow {
+
+namespace {
+
+int64_t saturating_multiply(int64_t value, int64_t multiplier)
+{
+    int64_t out;
+    if (__builtin_mul_overflow(value, multiplier, &out)) {
+        return value < 0 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+    }
+    return out;
+}
+
+}
+
+arrow::Status make_temporal_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                    std::unique_ptr<column_decoder>* out)
+{
+    if (types.time_unit != arrow::TimeUnit::MICRO && types.time_unit != arrow::TimeUnit::NANO) {
+        return arrow::Status::Invalid("time unit must be us or ns");
+    }
+    temporal_conversion conversion;
+    conversion.multiplier = types.time_unit == arrow::TimeUnit::NANO ? 1000 : 1;
+    conversion.infinity_as_null = types.infinity_as_null;
+    conversion.overflow = types.time_overflow;
+
+    switch (spec.oid) {
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID: {
+            conversion.offset = PG_EPOCH_OFFSET_USECS;
+            conversion.has_infinity = true;
+            conversion.infinity = saturating_multiply(types.timestamp_infinity, conversion.multiplier);
+            conversion.neg_infinity = saturating_multiply(types.timestamp_neg_infinity, conversion.multiplier);
+            auto type = spec.oid == TIMESTAMPOID ? arrow::timestamp(types.time_unit)
+                                                 : arrow::timestamp(types.time_unit, types.timezone);
+            out->reset(new temporal_decoder<pg_int8>(type, spec.name, conversion, pool));
+            break;
+        }
+        case DATEOID:
+            conversion.offset = PG_EPOCH_OFFSET_DAYS;
+            conversion.multiplier = 1;
+            conversion.has_infinity = true;
+            conversion.infinity = types.date_infinity;
+            conversion.neg_infinity = types.date_neg_infinity;
+            out->reset(new temporal_decoder<pg_int4>(arrow::date32(), spec.name, conversion, pool));
+            break;
+        case TIMEOID:
+            out->reset(new temporal_decoder<pg_int8>(arrow::time64(types.time_unit), spec.name, conversion, pool));
+            break;
+        case INTERVALOID:
+            out->reset(new interval_decoder(spec.name, types.time_overflow, pool));
+            break;
+        default:
+            return arrow::Status::Invalid("type oid ", spec.oid, " is not a date or time type");
+    }
+    return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "column_decoder.h"
+
+namespace pgarrow {
+
+/**
+ * @brief How the values of one temporal column map to Arrow:
+ *        out = (value + offset) * multiplier
+ */
+struct temporal_conversion {
+    /// PG epoch (2000-01-01) to Unix epoch, in the units sent
+    int64_t offset = 0;
+    /// sent units per Arrow unit, e.g. 1000 from microseconds to nanoseconds
+    int64_t multiplier = 1;
+    /// the type's extreme values stand for +-infinity
+    bool has_infinity = false;
+    /// +-infinity become NULL rather than the sentinels
+    bool infinity_as_null = false;
+    /// stored for +-infinity, in Arrow units
+    int64_t infinity = 0;
+    int64_t neg_infinity = 0;
+    /// values the Arrow unit cannot hold
+    value_policy overflow = value_policy::error;
+};
+
+/**
+ * @brief Decoder for timestamp, timestamptz, date and time columns, which PG
+ *        sends as integers counted from 2000-01-01 (or midnight).
+ *
+ * Runs of values are first byte swapped like any fixed width column. Each
+ * run is then checked against the range that converts without overflow,
+ * excluding the infinities, in one branch-free pass; if all values are in
+ * range, which is the norm, they are moved to the Unix epoch (and unit) by
+ * a second branch-free pass. Only runs with infinities or out of range
+ * values take the per value path that applies the sentinels and policies.
+ */
+template <typename Value>
+class temporal_decoder : public fixed_width_decoder<Value> {
+  public:
+    using c_type = typename Value::c_type;
+
+    temporal_decoder(std::shared_ptr<arrow::DataType> type, std::string name, const temporal_conversion& conversion,
+                     arrow::MemoryPool* pool) :
+        fixed_width_decoder<Value>(std::move(type), pool),
+        name_(std::move(name)),
+        conversion_(conversion)
+    {
+        using limits = std::numeric_limits<c_type>;
+        __int128 const offset = conversion_.offset;
+        __int128 const multiplier = conversion_.multiplier;
+        __int128 low = limits::min() / multiplier - offset;
+        __int128 high = limits::max() / multiplier - offset;
+        if (conversion_.has_infinity) {
+            low = std::max<__int128>(low, __int128(limits::min()) + 1);
+            high = std::min<__int128>(high, __int128(limits::max()) - 1);
+        }
+        low_ = static_cast<c_type>(std::max<__int128>(low, limits::min()));
+        high_ = static_cast<c_type>(std::min<__int128>(high, limits::max()));
+    }
+
+  protected:
+    arrow::Status convert(c_type* values, int64_t n) override
+    {
+        bool outside = false;
+        for (int64_t i = 0; i < n; ++i) {
+            outside |= (values[i] < low_) | (values[i] > high_);
+        }
+        if (outside) {
+            return convert_checked(values, n);
+        }
+        auto const offset = static_cast<c_type>(conversion_.offset);
+        auto const multiplier = static_cast<c_type>(conversion_.multiplier);
+        for (int64_t i = 0; i < n; ++i) {
+            values[i] = (values[i] + offset) * multiplier;
+        }
+        return arrow::Status::OK();
+    }
+
+  private:
+    arrow::Status convert_checked(c_type* values, int64_t n)
+    {
+        using limits = std::numeric_limits<c_type>;
+        int64_t const first_row = this->validity_.length() - n;
+        for (int64_t i = 0; i < n; ++i) {
+            c_type const value = values[i];
+            if (value >= low_ && value <= high_) {
+                values[i] = static_cast<c_type>((value + conversion_.offset) * conversion_.multiplier);
+                continue;
+            }
+            bool const infinite = conversion_.has_infinity && (value == limits::max() || value == limits::min());
+            if (infinite && !conversion_.infinity_as_null) {
+                values[i] = static_cast<c_type>(value == limits::max() ? conversion_.infinity : conversion_.neg_infinity);
+                continue;
+            }
+            if (!infinite && conversion_.overflow == value_policy::error) {
+                return arrow::Status::Invalid("value ", value, " of column '", name_, "' is out of range for ",
+                                              this->type_->ToString());
+            }
+            values[i] = 0;
+            ARROW_RETURN_NOT_OK(this->validity_.set_null(first_row + i));
+        }
+        return arrow::Status::OK();
+    }
+
+    std::string name_;
+    temporal_conversion conversion_;
+    // values in [low_, high_] convert without overflow
+    c_type low_;
+    c_type high_;
+};
+
+/**
+ * @brief Wire format of interval: int64 microseconds, int32 days and int32
+ *        months, decoded into Arrow's (months, days, nanoseconds) layout
+ *        with the time part still in microseconds (see interval_decoder)
+ */
+struct pg_interval {
+    using arrow_type = arrow::MonthDayNanoIntervalType;
+    using c_type = arrow::MonthDayNanoIntervalType::MonthDayNanos;
+    static constexpr int32_t width = 16;
+    static c_type decode(const char* buf)
+    {
+        return c_type{unpack_int32(buf + 12), unpack_int32(buf + 8), unpack_int64(buf)};
+    }
+    static void decode_bulk(c_type* values, int64_t n)
+    {
+        char* raw = reinterpret_cast<char*>(values);
+        for (int64_t i = 0; i < n; ++i) {
+            char field[width];
+            std::memcpy(field, raw + i * width, width);
+            values[i] = decode(field);
+        }
+    }
+    static void decode_strided(c_type* values, const char* buf, int64_t stride, int64_t n)
+    {
+        for (int64_t i = 0; i < n; ++i) {
+            values[i] = decode(buf + i * stride);
+        }
+    }
+};
+
+/**
+ * @brief Decoder for interval columns into month_day_nano_interval arrays.
+ *
+ * Months and days are kept apart as PG does, rather than folded into a
+ * duration. Only the time part changes, from microseconds to nanoseconds,
+ * which overflows beyond about 292 years; such values fail the decode or
+ * become NULL as the overflow policy says.
+ */
+class interval_decoder : public fixed_width_decoder<pg_interval> {
+  public:
+    interval_decoder(std::string name, value_policy overflow, arrow::MemoryPool* pool) :
+        fixed_width_decoder<pg_interval>(arrow::month_day_nano_interval(), pool),
+        name_(std::move(name)),
+        overflow_(overflow)
+    {
+    }
+
+  protected:
+    arrow::Status convert(c_type* values, int64_t n) override
+    {
+        constexpr int64_t limit = std::numeric_limits<int64_t>::max() / 1000;
+        bool outside = false;
+        for (int64_t i = 0; i < n; ++i) {
+            outside |= (values[i].nanoseconds < -limit) | (values[i].nanoseconds > limit);
+        }
+        if (outside) {
+            return convert_checked(values, n);
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            values[i].nanoseconds *= 1000;
+        }
+        return arrow::Status::OK();
+    }
+
+  private:
+    arrow::Status convert_checked(c_type* values, int64_t n)
+    {
+        constexpr int64_t limit = std::numeric_limits<int64_t>::max() / 1000;
+        int64_t const first_row = this->validity_.length() - n;
+        for (int64_t i = 0; i < n; ++i) {
+            if (values[i].nanoseconds >= -limit && values[i].nanoseconds <= limit) {
+                values[i].nanoseconds *= 1000;
+                continue;
+            }
+            if (overflow_ == value_policy::error) {
+                return arrow::Status::Invalid("time part of ", values[i].nanoseconds, " microseconds in column '",
+                                              name_, "' is out of range for ", this->type_->ToString());
+            }
+            values[i] = c_type{0, 0, 0};
+            ARROW_RETURN_NOT_OK(this->validity_.set_null(first_row + i));
+        }
+        return arrow::Status::OK();
+    }
+
+    std::string name_;
+    value_policy overflow_;
+};
+
+/**
+ * @brief Create the decoder for a timestamp, timestamptz, date, time or
+ *        interval column
+ */
+arrow::Status make_temporal_decoder(const column_spec& spec, const type_options& types, arrow::MemoryPool* pool,
+                                    std::unique_ptr<column_decoder>* out);
+
+}
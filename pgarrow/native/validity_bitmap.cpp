@@ -0,0 +1,69 @@
+#include "validity_bitmap.h"
+
+namespace pgarrow {
+
+validity_bitmap::validity_bitmap(arrow::MemoryPool* pool) :
+    words_(pool),
+    length_(0),
+    null_count_(0),
+    expected_length_(0)
+{
+}
+
+arrow::Status validity_bitmap::allocate()
+{
+    ARROW_RETURN_NOT_OK(words_.Reserve(words_for(std::max(expected_length_, length_ + 1))));
+    int64_t const full_words = length_ >> 6;
+    ARROW_RETURN_NOT_OK(words_.Append(full_words, ~uint64_t(0)));
+    if (length_ & 63) {
+        ARROW_RETURN_NOT_OK(words_.Append((uint64_t(1) << (length_ & 63)) - 1));
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status validity_bitmap::append_valid(int64_t n)
+{
+    if (null_count_ == 0) {
+        length_ += n;
+        return arrow::Status::OK();
+    }
+    if (n <= 0) {
+        return arrow::Status::OK();
+    }
+    int64_t const missing = words_for(length_ + n) - words_.length();
+    if (missing > 0) {
+        ARROW_RETURN_NOT_OK(words_.Append(missing, uint64_t(0)));
+    }
+    uint64_t* const words = words_.mutable_data();
+    int64_t const end = length_ + n;
+    int64_t const first = length_ >> 6;
+    int64_t const last = (end - 1) >> 6;
+    uint64_t const head = ~uint64_t(0) << (length_ & 63);
+    uint64_t const tail = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+    if (first == last) {
+        words[first] |= head & tail;
+    } else {
+        words[first] |= head;
+        std::fill(words + first + 1, words + last, ~uint64_t(0));
+        words[last] |= tail;
+    }
+    length_ = end;
+    return arrow::Status::OK();
+}
+
+arrow::Status validity_bitmap::finish(std::shared_ptr<arrow::Buffer>* out)
+{
+    if (null_count_ == 0) {
+        out->reset();
+    } else {
+        words_to_bitmap(words_.mutable_data(), words_.length());
+        ARROW_RETURN_NOT_OK(words_.Finish(out));
+    }
+    words_.Reset();
+    length_ = 0;
+    null_count_ = 0;
+    expected_length_ = 0;
+    return arrow::Status::OK();
+}
+
+}
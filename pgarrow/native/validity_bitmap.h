@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+#include <arrow/api.h>
+#include <arrow/util/endian.h>
+
+namespace pgarrow {
+
+/**
+ * @brief Put `n` words whose bits were set with 64-bit shifts into Arrow's
+ *        bit order, which numbers bits within bytes: a byte swap on big
+ *        endian hosts, nothing on little endian ones
+ */
+inline void words_to_bitmap(uint64_t* words, int64_t n)
+{
+#if !ARROW_LITTLE_ENDIAN
+    for (int64_t i = 0; i < n; ++i) {
+        words[i] = arrow::bit_util::ToLittleEndian(words[i]);
+    }
+#else
+    (void)words;
+    (void)n;
+#endif
+}
+
+/**
+ * @brief Validity bitmap of a column under construction.
+ *
+ * Nothing is allocated until the first NULL is appended; up to then only
+ * the length is counted, so columns without NULLs cost neither memory nor
+ * bit operations. Once allocated, bits are set a 64-bit word at a time, only
+ * ever through word operations so the bit order holds on any host, and the
+ * null count is kept as NULLs arrive.
+ */
+class validity_bitmap {
+  public:
+    explicit validity_bitmap(arrow::MemoryPool* pool);
+
+    int64_t length() const { return length_; }
+    int64_t null_count() const { return null_count_; }
+
+    /**
+     * @brief Make room for `n` more entries. Before the first NULL this is
+     *        only remembered, so that allocating the bitmap reserves them.
+     */
+    arrow::Status reserve(int64_t n)
+    {
+        expected_length_ = std::max(expected_length_, length_ + n);
+        if (null_count_ == 0 || words_for(expected_length_) <= words_.capacity()) {
+            return arrow::Status::OK();
+        }
+        return words_.Resize(words_for(expected_length_));
+    }
+
+    /**
+     * @brief Append one valid entry
+     */
+    arrow::Status append_valid()
+    {
+        if (null_count_ == 0) {
+            ++length_;
+            return arrow::Status::OK();
+        }
+        if ((length_ & 63) == 0) {
+            ARROW_RETURN_NOT_OK(words_.Append(uint64_t(1)));
+        } else {
+            words_.mutable_data()[length_ >> 6] |= uint64_t(1) << (length_ & 63);
+        }
+        ++length_;
+        return arrow::Status::OK();
+    }
+
+    /**
+     * @brief Append `n` valid entries
+     */
+    arrow::Status append_valid(int64_t n);
+
+    /**
+     * @brief Append one NULL entry, allocating the bitmap on the first
+     */
+    arrow::Status append_null()
+    {
+        if (null_count_ == 0) {
+            ARROW_RETURN_NOT_OK(allocate());
+        }
+        if ((length_ & 63) == 0) {
+            ARROW_RETURN_NOT_OK(words_.Append(uint64_t(0)));
+        }
+        ++length_;
+        ++null_count_;
+        return arrow::Status::OK();
+    }
+
+    /**
+     * @brief Turn the already appended, valid entry `i` into a NULL
+     */
+    arrow::Status set_null(int64_t i)
+    {
+        if (null_count_ == 0) {
+            ARROW_RETURN_NOT_OK(allocate());
+        }
+        words_.mutable_data()[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        ++null_count_;
+        return arrow::Status::OK();
+    }
+
+    /**
+     * @brief Hand out the bitmap (nullptr if there were no NULLs) and start
+     *        over empty
+     */
+    arrow::Status finish(std::shared_ptr<arrow::Buffer>* out);
+
+  private:
+    static int64_t words_for(int64_t bits) { return (bits + 63) >> 6; }
+
+    /**
+     * @brief Allocate the words for the entries so far, all of them valid
+     */
+    arrow::Status allocate();
+
+    arrow::TypedBufferBuilder<uint64_t> words_;
+    int64_t length_;
+    int64_t null_count_;
+    int64_t expected_length_;
+};
+
+}
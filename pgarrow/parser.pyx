@@ -1,17 +1,18 @@
 # distutils: language=c++
+# distutils: sources = [pgarrow/native/copy_decoder.cpp, pgarrow/native/column_decoder.cpp, pgarrow/native/mapped_file.cpp, pgarrow/native/validity_bitmap.cpp, pgarrow/native/arena_pool.cpp, pgarrow/native/binary_decoder.cpp, pgarrow/native/dictionary_decoder.cpp, pgarrow/native/string_dictionary.cpp, pgarrow/native/numeric_decoder.cpp, pgarrow/native/temporal_decoder.cpp, pgarrow/native/array_decoder.cpp, pgarrow/native/struct_decoder.cpp, pgarrow/native/range_decoder.cpp, pgarrow/native/address_decoder.cpp, pgarrow/native/json_decoder.cpp, pgarrow/native/hstore_decoder.cpp, pgarrow/native/geometry_decoder.cpp, pgarrow/native/bit_decoder.cpp]
 # cython: infer_types=True
 # cython: profile=True
 
 import io
+import json
+import os
+import re
 from libcpp cimport bool
 from libc.stdint cimport int16_t, int32_t, uint16_t, uint32_t, int64_t, uint64_t
 
 from libcpp.memory cimport shared_ptr, unique_ptr
 from libcpp.vector cimport vector
 
-from cpython cimport array
-import array
-
 from hton cimport unpack_int16, unpack_int32, unpack_int64, unpack_float, unpack_double
 import datetime
 
@@ -24,218 +25,644 @@ cimport pyarrow.lib as palib
 
 from pyarrow.lib cimport *
 
-# from builder cimport AbstractBuilder, DoubleBuilder, Int64Builder
+from decoderlib cimport CColumnSpec, CTypeKind, CValuePolicy, CParallelMode, CDecodeOptions, CCopyDecoder, CMappedFile, decode_mapped_file
+from decoderlib cimport CArenaOptions, CArenaMemoryPool
 
 
 
 include "typemap.pxi"
 
 
-cdef dict PG_PA_TYPEMAP = {
-    BOOLOID: pa.bool_(),
-    INT2OID: pa.int16(),
-    INT4OID: pa.int32(),
-    INT8OID: pa.int64(),
-    FLOAT4OID: pa.float32(),
-    FLOAT8OID: pa.float64(),
-    TIMESTAMPOID: pa.timestamp('ns')
+# oids of the type names used in field types
+cdef dict TYPE_OIDS = {v: k for k, v in TYPEMAP.items()}
+
+FIELD_TYPE_RE = re.compile(r'^\s*([^(]*?)\s*(?:\(([-\w,\s]*)\))?\s*$')
+
+ARRAY_TYPE_RE = re.compile(r'^(.*?)\s*((?:\[\s*\d*\s*\])+)$')
 
+# encode the modifiers of a field type like pg_attribute.atttypmod; PostGIS
+# keeps the SRID in bits 8 to 28, of which only it is used (geography is 4326
+# unless declared otherwise)
+cdef dict TYPMODS = {
+    'numeric': lambda precision, scale=0: ((precision << 16) | (scale & 0x7ff)) + 4,
+    'vector': lambda dim: dim,
+    'bit': lambda length: length,
+    'geometry': lambda subtype, srid=0: (srid & 0x1fffff) << 8,
+    'geography': lambda subtype='Geometry', srid=4326: (srid & 0x1fffff) << 8,
 }
 
+# pgvector's type, which has no fixed oid
+PGVECTOR_TYPE = 'vector'
 
-cdef dict PA_PY_TYPEMAP = {
-    pa.int64(): 'l',
-    pa.float64(): 'd',
-    pa.timestamp('ns'): 'd'
+# hstore's type, which has no fixed oid either
+HSTORE_TYPE = 'hstore'
 
+# PostGIS's types, likewise
+POSTGIS_TYPES = ('geometry', 'geography')
+
+# subtypes of the builtin range types
+RANGE_SUBTYPES = {
+    'int4range': 'int4',
+    'int8range': 'int8',
+    'numrange': 'numeric',
+    'tsrange': 'timestamp',
+    'tstzrange': 'timestamptz',
+    'daterange': 'date',
 }
 
 
-cdef get_pg_oids(field_types):
-    """
-    Convert text field types to PG field OIDs
-    :param field_types: 
-    :return: 
-    """
-    tmap = {v: k for k, v in TYPEMAP.items()}
-    return [tmap[t] for t in field_types]
-
-# cdef make_array_builder_inttype(patyp):
-#     if patyp == Type._Type_DOUBLE:
-#         return DoubleBuilder()
-#     elif patyp == Type._Type_INT64:
-#         return Int64Builder()
-#     elif patyp == Type._Type_TIMESTAMP:
-#         return DoubleBuilder()
-
-cdef make_array_builder(DataType patyp):
-    pytype = PA_PY_TYPEMAP[patyp]
-    cdef array.array a = array.array(pytype)
-
-    return a
-    # if patyp == pa.float64():
-    #     return DoubleBuilder()
-    # elif patyp == pa.int64():
-    #     return Int64Builder()
-    # elif patyp == pa.timestamp('ns'):
-    #     return Int64Builder()
-
-
-cdef prepare_column_builders(field_types):
-    # TODO need to enforce that these are never None
-    return [make_array_builder(typ) for typ in field_types]
-
-
-cdef columns_to_arrow_table(columns, fields, data_types, n_rows):
-    data = []
-    for i in range(len(columns)):
-        dtype = data_types[i]
-        field = fields[i]
-        column_builder = columns[i]
-        data.append(pa.array(column_builder))
-        # data.append(column_builder.finish())
-
-    return Table.from_arrays(data, [f.name for f in fields])
-
-
-cdef parse_header(buffer):
-    intro = buffer.read(11)
-    # TODO should check PGCOPY intro for errors
-    flags = unpack_int32(buffer.read(4))
-    header_extension = unpack_int32(buffer.read(4))
-    return buffer
-
-# TODO compare using builders to python lists that cpython will optimize
-# cdef bool read_tuple(buffer, column_builders):
-#     # Field count
-#     cdef int16_t n_fields = unpack_int16(buffer.read(2))
-#     if n_fields == -1:
-#         # End reached
-#         return False
-#
-#     cdef int32_t len_field = 0
-#     cdef AbstractBuilder builder
-#
-#     cdef bytes field_dat
-#
-#     for i in range(n_fields):
-#         len_field = unpack_int32(buffer.read(4))
-#
-#         builder = column_builders[i]
-#         if len_field == -1:
-#             # Null field
-#             builder.append_null()
-#             continue
-#
-#         field_dat = buffer.read(len_field)
-#         builder.append_bytes(field_dat)
-#
-#     return True
+cdef parse_field_type(field_type):
+    """
+    Split a field type such as ``numeric(12, 2)`` or ``geometry(Point, 4326)``
+    into the type name and its typmod, -1 if it has no modifiers (or none the
+    decoder uses). A plain ``geography`` has the typmod of its default SRID.
+    """
+    match = FIELD_TYPE_RE.match(field_type)
+    if match is None:
+        return field_type, -1
+    name = match.group(1)
+    if match.group(2) is None:
+        return name, TYPMODS['geography']() if name == 'geography' else -1
+    if name not in TYPMODS:
+        return name, -1
+    args = [arg.strip() for arg in match.group(2).split(',')]
+    return name, TYPMODS[name](*[int(arg) if arg.lstrip('-').isdigit() else arg for arg in args])
+
+
+cdef CColumnSpec make_column_spec(name, field_type, enums, composites, ranges) except *:
+    """
+    Describe a column of `field_type`. ``type[]`` is an array of type, of any
+    shape; ``type[3][4]`` an array of that shape.
+    """
+    cdef CColumnSpec spec
+    field_type = field_type.strip()
+    spec.name = name.encode('utf8')
+    match = ARRAY_TYPE_RE.match(field_type)
+    if match:
+        dims = re.findall(r'\[\s*(\d*)\s*\]', match.group(2))
+        if all(dims):
+            spec.dims = [int(d) for d in dims]
+        elif any(dims):
+            raise ValueError('give all dimensions of {} or none'.format(field_type))
+        spec.kind = CTypeKind.array
+        spec.oid = TYPE_OIDS.get(field_type, 0)
+        spec.typmod = -1
+        spec.children.push_back(make_column_spec('item', match.group(1), enums, composites, ranges))
+        return spec
+    type_name, typmod = parse_field_type(field_type)
+    spec.typmod = typmod
+    if type_name in enums:
+        spec.oid = 0
+        spec.enum_labels = [label.encode('utf8') for label in enums[type_name]]
+    elif type_name in composites:
+        spec.kind = CTypeKind.composite
+        spec.oid = 0
+        for attribute_name, attribute_type in composites[type_name]:
+            spec.children.push_back(make_column_spec(attribute_name, attribute_type, enums, composites, ranges))
+    elif type_name in ranges or type_name in RANGE_SUBTYPES:
+        spec.kind = CTypeKind.range
+        spec.oid = 0
+        spec.children.push_back(make_column_spec(name, ranges.get(type_name) or RANGE_SUBTYPES[type_name],
+                                                 enums, composites, ranges))
+    elif type_name == HSTORE_TYPE:
+        spec.kind = CTypeKind.hstore
+        spec.oid = 0
+    elif type_name in POSTGIS_TYPES:
+        spec.kind = CTypeKind.postgis
+        spec.oid = 0
+    elif type_name == PGVECTOR_TYPE:
+        spec.kind = CTypeKind.vector
+        spec.oid = 0
+        spec.children.push_back(make_column_spec('item', 'float4', enums, composites, ranges))
+    else:
+        spec.oid = TYPE_OIDS[type_name]
+    return spec
+
+
+cdef vector[CColumnSpec] make_column_specs(field_names, field_types, enums, composites, ranges, json_structs):
+    cdef vector[CColumnSpec] specs
+    cdef CColumnSpec spec
+    json_structs = dict(json_structs)
+    for name, field_type in zip(field_names, field_types):
+        spec = make_column_spec(name, field_type, enums, composites, ranges)
+        if name in json_structs:
+            if spec.kind != CTypeKind.base or spec.oid not in (JSONOID, JSONBOID):
+                raise ValueError('json_struct column {} is not of type json or jsonb'.format(name))
+            json_type = json_structs.pop(name)
+            if isinstance(json_type, pa.Schema):
+                json_type = pa.struct(list(json_type))
+            spec.json_struct = True
+            if json_type is not None:
+                spec.json_type = pyarrow_unwrap_data_type(json_type)
+        specs.push_back(spec)
+    if json_structs:
+        raise ValueError('unknown json_struct columns: {}'.format(', '.join(json_structs)))
+    return specs
+
+
+def base_type_name(field_type):
+    """
+    Name of the type of `field_type` without modifiers, or of its elements for arrays
+    """
+    match = ARRAY_TYPE_RE.match(field_type.strip())
+    return parse_field_type(match.group(1) if match else field_type)[0]
+
+
+def load_enum_labels(cursor, type_names):
+    """
+    Labels of the given enum types in their sort order, as a dict keyed by type
+    name, read from pg_enum with a single query. Names that are not enum types
+    are left out.
+    """
+    cursor.execute('SELECT n, array_agg(e.enumlabel ORDER BY e.enumsortorder) '
+                   'FROM unnest(%s::text[]) AS n JOIN pg_enum e ON e.enumtypid = to_regtype(n) '
+                   'GROUP BY n', (list(type_names),))
+    return {name: list(labels) for name, labels in cursor.fetchall()}
+
+
+def load_composite_attributes(cursor, type_names):
+    """
+    Attributes of the given composite types as a dict keyed by type name of
+    (name, field type) lists in attribute order, read from pg_attribute with a
+    single query. Names that are not composite types are left out.
+    """
+    cursor.execute(
+        "SELECT n, array_agg(a.attname::text ORDER BY a.attnum), "
+        "array_agg(coalesce(et.typname, at.typname) "
+        "|| coalesce(substring(format_type(a.atttypid, a.atttypmod) FROM '\\(.*\\)'), '') "
+        "|| CASE WHEN et.oid IS NULL THEN '' ELSE '[]' END ORDER BY a.attnum) "
+        "FROM unnest(%s::text[]) AS n JOIN pg_type t ON t.oid = to_regtype(n) "
+        "JOIN pg_attribute a ON a.attrelid = t.typrelid AND a.attnum > 0 AND NOT a.attisdropped "
+        "JOIN pg_type at ON at.oid = a.atttypid "
+        "LEFT JOIN pg_type et ON et.oid = at.typelem AND at.typcategory = 'A' "
+        "GROUP BY n", (list(type_names),))
+    return {name: list(zip(names, types)) for name, names, types in cursor.fetchall()}
+
+
+def load_range_subtypes(cursor, type_names):
+    """
+    Subtypes of the given range types as a dict keyed by type name, read from
+    pg_range with a single query. Names that are not range types are left out.
+    """
+    cursor.execute('SELECT n, st.typname::text FROM unnest(%s::text[]) AS n '
+                   'JOIN pg_range r ON r.rngtypid = to_regtype(n) JOIN pg_type st ON st.oid = r.rngsubtype',
+                   (list(type_names),))
+    return dict(cursor.fetchall())
+
+
+def resolve_types(cursor, field_types, enums, composites, ranges):
+    """
+    Look up the enum labels, composite attributes and range subtypes of the
+    types in `field_types` that are neither builtin nor in `enums`,
+    `composites` or `ranges`, and of the types of those attributes and
+    subtypes in turn. Returns the extended enums, composites and ranges.
+    """
+    enums, composites, ranges = dict(enums), dict(composites), dict(ranges)
+    field_types = list(field_types)
+    while True:
+        known = (set(TYPEMAP.values()) | {PGVECTOR_TYPE, HSTORE_TYPE} | set(POSTGIS_TYPES) |
+                 set(RANGE_SUBTYPES) | set(enums) | set(composites) | set(ranges))
+        unknown = {base_type_name(t) for t in field_types} - known
+        if not unknown:
+            return enums, composites, ranges
+        enums.update(load_enum_labels(cursor, unknown))
+        found_composites = load_composite_attributes(cursor, unknown)
+        found_ranges = load_range_subtypes(cursor, unknown)
+        # types that are none of these are reported when decoding
+        composites.update(found_composites)
+        ranges.update(found_ranges)
+        field_types = [t for attributes in found_composites.values() for _, t in attributes]
+        field_types += found_ranges.values()
+
+
+cdef dict PARALLEL_MODES = {
+    'auto': CParallelMode.automatic,
+    'columns': CParallelMode.columns,
+    'chunks': CParallelMode.chunks,
+}
 
+cdef dict VALUE_POLICIES = {
+    'error': CValuePolicy.error,
+    'null': CValuePolicy.null,
+}
 
-cdef pg_bswap64(x):
-    return (
-        ((x << 56) & 0xff00000000000000) |
-        ((x << 40) & 0x00ff000000000000) |
-        ((x << 24) & 0x0000ff0000000000) |
-        ((x << 8) & 0x000000ff00000000) |
-        ((x >> 8) & 0x00000000ff000000) |
-        ((x >> 24) & 0x0000000000ff0000) |
-        ((x >> 40) & 0x000000000000ff00) |
-        ((x >> 56) & 0x00000000000000ff)
-    )
+cdef dict TIME_UNITS = {
+    'us': TimeUnit_MICRO,
+    'ns': TimeUnit_NANO,
+}
 
+# +-infinity timestamps (Unix epoch microseconds) and dates (Unix epoch days)
+# stored as the latest and earliest Python datetimes, see protocol/codecs/datetime.pyx
+DATETIME_INFINITY = (253402300799999999, -62135596800000000, 2932896, -719162)
 
-cdef bool read_tuple(buffer, column_builders):
-    # Field count
-    cdef int16_t n_fields = unpack_int16(buffer.read(2))
-    if n_fields == -1:
-        # End reached
-        return False
-
-    cdef int32_t len_field = 0
-    cdef array.array builder
-
-    cdef bytes field_dat
-
-    for i in range(n_fields):
-        len_field = unpack_int32(buffer.read(4))
-
-        # builder = column_builders[i]
-        builder = column_builders[i]
-        # builder.resize_smart(1)
-
-        if len_field == -1:
-            # Null field
-            # builder.append(None)
-            # TODO add field len
-            builder.append(b'\x00\x00\x00\x00')
-            # mask.append(True)
-            continue
-
-        field_dat = buffer.read(len_field)
 
-        builder.append(unpack_int64(field_dat))
-        column_builders[i] = builder
-        # builder += pg_bswap64(<uint64_t>field_dat)
-        # builder.append(field_dat)
-
-    return True
+cdef CDecodeOptions make_decode_options(options) except *:
+    """
+    Build the native decode options from the keyword arguments of the read functions
+
+    use_threads: decode in parallel on the Arrow CPU thread pool
+    parallel: 'columns' to decode each column on its own thread, 'chunks' to split
+        the data into byte ranges decoded into separate batches, or 'auto' to use
+        chunks for tables with fewer columns than threads
+    window_size: bytes of a complete buffer or file indexed per step when column-parallel
+    chunk_size: minimum bytes per range when chunk-parallel
+    expected_rows: rows the data is expected to hold, used to size the columns up
+        front; estimated from the first rows decoded when not given
+    string_view: decode text and bytea columns as string_view/binary_view arrays
+        pointing into the input (which the table then keeps alive) instead of copying
+    large_strings: decode text, bytea, json and jsonb columns as large_utf8/large_binary,
+        for batches holding more than 2 GB of them
+    strings_as_dictionary: decode text columns as dictionary<int32, utf8>, going back
+        to plain strings for columns that turn out to have many distinct values
+    dictionary_max_size: distinct values per batch above which a text column stops
+        being dictionary encoded
+    numeric_precision, numeric_scale: decimal type of numeric columns declared
+        without precision (numeric(p, s) columns use their own)
+    numeric_overflow: 'error' (default) or 'null' for numerics too large for the
+        precision
+    numeric_special: 'null' (default) or 'error' for numeric NaN and +-Infinity
+    time_unit: 'us' (default) or 'ns', unit of timestamp, timestamptz and time columns
+    timezone: time zone of timestamptz columns, 'UTC' by default; values are UTC
+        either way
+    infinity: how +-infinity timestamps and dates are stored: 'extremes' (default)
+        as the largest and smallest values of the Arrow type, 'datetime' as
+        datetime.max and datetime.min (so they convert to Python), or 'null'
+    time_overflow: 'error' (default) or 'null' for timestamps out of range of
+        the time unit, and intervals whose time part overflows nanoseconds
+    large_lists: decode array columns (field types such as ``float8[]``) as
+        large_list rather than list
+    fixed_size_arrays: decode arrays of fixed width types as fixed_size_list, or
+        fixed_shape_tensor if multidimensional, of the shape of the first value,
+        as is always done for arrays declared with a shape (``float4[768]``,
+        ``float4[3][4]``) and pgvector ``vector`` columns
+    """
+    cdef CDecodeOptions c_options
+    options = dict(options)
+    c_options.use_threads = options.pop('use_threads', True)
+    c_options.parallel = PARALLEL_MODES[options.pop('parallel', 'auto')]
+    c_options.window_size = options.pop('window_size', c_options.window_size)
+    c_options.chunk_size = options.pop('chunk_size', c_options.chunk_size)
+    c_options.expected_rows = options.pop('expected_rows', c_options.expected_rows)
+    c_options.types.string_view = options.pop('string_view', False)
+    c_options.types.large_strings = options.pop('large_strings', False)
+    c_options.types.strings_as_dictionary = options.pop('strings_as_dictionary', False)
+    c_options.types.dictionary_max_size = options.pop('dictionary_max_size',
+                                                      c_options.types.dictionary_max_size)
+    c_options.types.numeric_precision = options.pop('numeric_precision', c_options.types.numeric_precision)
+    c_options.types.numeric_scale = options.pop('numeric_scale', c_options.types.numeric_scale)
+    c_options.types.numeric_overflow = VALUE_POLICIES[options.pop('numeric_overflow', 'error')]
+    c_options.types.numeric_special = VALUE_POLICIES[options.pop('numeric_special', 'null')]
+    c_options.types.time_unit = TIME_UNITS[options.pop('time_unit', 'us')]
+    c_options.types.timezone = options.pop('timezone', 'UTC').encode('utf8')
+    infinity = options.pop('infinity', 'extremes')
+    if infinity == 'null':
+        c_options.types.infinity_as_null = True
+    elif infinity == 'datetime':
+        (c_options.types.timestamp_infinity, c_options.types.timestamp_neg_infinity,
+         c_options.types.date_infinity, c_options.types.date_neg_infinity) = DATETIME_INFINITY
+    elif infinity != 'extremes':
+        raise ValueError("infinity must be 'extremes', 'datetime' or 'null'")
+    c_options.types.time_overflow = VALUE_POLICIES[options.pop('time_overflow', 'error')]
+    c_options.types.large_lists = options.pop('large_lists', False)
+    c_options.types.fixed_size_arrays = options.pop('fixed_size_arrays', False)
+    if options:
+        raise TypeError('unexpected decode options: {}'.format(', '.join(options)))
+    return c_options
+
+
+cdef make_decoder(field_names, field_types, options, unique_ptr[CCopyDecoder]* decoder):
+    """
+    Create the native decoder, allocating from the ``memory_pool`` option if given.
+    The ``enums`` option maps enum type names used in `field_types` to their
+    labels in sort order (see load_enum_labels); such columns are decoded as
+    dictionaries of the labels. The ``composites`` option maps composite type
+    names to their attributes as (name, field type) pairs (see
+    load_composite_attributes); such columns are decoded as structs. Any name
+    will do, e.g. for the anonymous records of ROW(...) expressions. The
+    ``ranges`` option maps range type names other than the builtin ones to
+    their subtype (see load_range_subtypes); range columns are decoded as
+    struct<lower, upper, lower_inclusive, upper_inclusive, empty>, hstore
+    columns as map<utf8, utf8> and PostGIS geometry and geography columns as
+    geoarrow.wkb, with the SRID they are declared with (as in
+    ``geometry(Point, 4326)``) in the metadata. json and jsonb columns are
+    decoded as utf8 (the text of the values), except those in the
+    ``json_struct`` option, which maps column names to the struct type (or
+    schema) to parse their objects into, or None to infer it from the first
+    batch holding values (which rules out chunk-parallel decoding). bit(n)
+    columns are decoded as fixed_size_binary of their bytes, varbit columns
+    (and bit columns without a length) as struct<bits: binary, length: int32>.
+    """
+    options = dict(options)
+    memory_pool = options.pop('memory_pool', None)
+    enums = options.pop('enums', {})
+    composites = options.pop('composites', {})
+    ranges = options.pop('ranges', {})
+    json_structs = options.pop('json_struct', {})
+    cdef vector[CColumnSpec] specs = make_column_specs(field_names, field_types, enums, composites, ranges,
+                                                       json_structs)
+    cdef CDecodeOptions c_options = make_decode_options(options)
+    check_status(CCopyDecoder.make(specs, c_options, maybe_unbox_memory_pool(memory_pool), decoder))
+
+
+cdef class ArenaMemoryPool(MemoryPool):
+    """
+    Memory pool mapping column memory from the kernel in large pieces: buffers
+    below an eighth of ``arena_size`` share arenas of that size, larger ones get
+    a mapping of their own that grows without copying. ``huge_pages`` uses
+    reserved huge pages (MAP_HUGETLB) where available, ``transparent_huge_pages``
+    asks for THP on normal mappings.
+
+    Pass it to the read functions as ``memory_pool``. Arrays only keep a plain
+    pointer to their pool, so a pool whose memory is still in use when it is
+    garbage collected lives on until its last buffer is freed.
+    """
+    cdef unique_ptr[CArenaMemoryPool] arena
+
+    def __init__(self, arena_size=64 << 20, huge_pages=False, transparent_huge_pages=True):
+        cdef CArenaOptions options
+        options.arena_size = arena_size
+        options.huge_pages = huge_pages
+        options.transparent_huge_pages = transparent_huge_pages
+        check_status(CArenaMemoryPool.make(options, &self.arena))
+        self.init(self.arena.get())
+
+    def __dealloc__(self):
+        if self.arena.get() != NULL:
+            # deleted by its last buffer, or right away if there is none
+            self.arena.release().orphan()
+
+    def release_unused(self):
+        """
+        Unmap the current arena if no buffer is left in it
+        """
+        # MemoryPool.release_unused acts on the default pool, not on self
+        with nogil:
+            self.arena.get().ReleaseUnused()
+
+    @property
+    def mapped_bytes(self):
+        """
+        Bytes currently mapped from the kernel
+        """
+        return self.arena.get().mapped_bytes()
+
+    @property
+    def fragmentation(self):
+        """
+        Share of the mapped bytes not holding live buffers
+        """
+        return self.arena.get().fragmentation()
+
+
+cdef process_buffer(const unsigned char[::1] data, field_names, field_types, options, Buffer source=None):
+    """
+    Decode a complete COPY BINARY payload with the native decoder.
+    The GIL is released for the whole decode loop. `source`, if given, is the
+    pyarrow Buffer `data` belongs to, which string views may reference.
+    """
+    cdef unique_ptr[CCopyDecoder] decoder
+    cdef shared_ptr[CTable] table
+    cdef CStatus status
+    cdef const char* c_data = NULL
+    cdef int64_t size = data.shape[0]
 
+    make_decoder(field_names, field_types, options, &decoder)
+    if size > 0:
+        c_data = <const char*> &data[0]
+    if source is not None:
+        decoder.get().set_source(pyarrow_unwrap_buffer(source))
 
-cdef int process_buffer(buffer, column_builders):
-    parse_header(buffer)
-    cont = True
-    cdef int counter = 0
-    while cont:
-        cont = read_tuple(buffer, column_builders)
-        counter += 1
-    return counter
+    with nogil:
+        status = decoder.get().decode_table(c_data, size, &table)
+    check_status(status)
 
+    return pyarrow_wrap_table(table)
 
-cdef _read_pg_buffer(buffer, field_names, field_types):
 
-    # wrangle field type defs
-    pg_oids = get_pg_oids(field_types)
-    pa_object_field_type = [PG_PA_TYPEMAP[oid] for oid in pg_oids]
-
-    # pa_field_types = [PG_OID_TYPEMAP[pg_oid] for pg_oid in pg_oids]
-
-    fields = [pa.field(n, t) for n, t in zip(field_names, pa_object_field_type)]
+cdef buffer_contents(buffer):
+    """
+    Get the unread part of a file-like object as something supporting the buffer
+    protocol, without copying when the buffer is an in memory BytesIO
+    """
+    if isinstance(buffer, io.BytesIO):
+        return buffer.getbuffer()[buffer.tell():]
+    return buffer.read()
 
-    column_builders = prepare_column_builders(pa_object_field_type)
-    n_rows = process_buffer(buffer, column_builders)
-
-    return columns_to_arrow_table(column_builders, fields, pa_object_field_type, n_rows)
 
+cdef immutable_contents(buffer):
+    """
+    Get the unread part of a file-like object as a pyarrow Buffer that will not
+    change later, for arrays that keep referencing it
+    """
+    if isinstance(buffer, io.BytesIO):
+        # shares the BytesIO's bytes object unless it was written to since
+        return pa.py_buffer(buffer.getvalue()).slice(buffer.tell())
+    data = buffer.read()
+    if not isinstance(data, bytes):
+        data = bytes(data)
+    return pa.py_buffer(data)
+
+
+cdef _read_pg_buffer(buffer, field_names, field_types, options):
+    if options.get('string_view'):
+        source = immutable_contents(buffer)
+        # pyarrow Buffers export signed bytes ('b'), viewed as unsigned here
+        contents = memoryview(source).cast('B')
+        try:
+            return process_buffer(contents, field_names, field_types, options, source)
+        finally:
+            contents.release()
+
+    contents = buffer_contents(buffer)
+    try:
+        return process_buffer(contents, field_names, field_types, options)
+    finally:
+        if isinstance(contents, memoryview):
+            contents.release()
+
+
+def read_pg_buffer(buffer, field_names, field_types, **options):
+    return _read_pg_buffer(buffer, field_names, field_types, options)
+
+
+cdef _read_pg_file(filename, field_names, field_types, options):
+    """
+    Decode a saved COPY BINARY file straight from a read-only memory mapping,
+    falling back to reading it into memory where mmap is not available
+    """
+    cdef shared_ptr[CMappedFile] mapped
+    cdef unique_ptr[CCopyDecoder] decoder
+    cdef shared_ptr[CTable] table
+    cdef CStatus status
 
-def read_pg_buffer(buffer, field_names, field_types):
-    return _read_pg_buffer(buffer, field_names, field_types)
+    status = CMappedFile.open(os.fsencode(filename), &mapped)
+    if status.IsNotImplemented():
+        with open(filename, 'rb') as buffer:
+            return _read_pg_buffer(buffer, field_names, field_types, options)
+    check_status(status)
 
+    make_decoder(field_names, field_types, options, &decoder)
+    with nogil:
+        status = decode_mapped_file(decoder.get(), mapped, &table)
+    check_status(status)
 
-cdef _read_pg_file(filename, field_names, field_types):
-    with open(filename, 'rb') as buffer:
-        return _read_pg_buffer(buffer, field_names, field_types)
+    return pyarrow_wrap_table(table)
 
 
-def read_pg_file(filename, field_names, field_types):
-    return _read_pg_file(filename, field_names, field_types)
+def read_pg_file(filename, field_names, field_types, **options):
+    return _read_pg_file(filename, field_names, field_types, options)
 
 # NOTE: possible to just build a list of values and then to array, but not very fast
 # (about 2/3rds or 1.5x faster, aiming for 2-3x)
 
-cdef _read_pg_query(cursor, query, field_names, field_types):
-    # buffer = _ParserIO()
-    # cursor.copy_expert(query, buffer)
-    # with _ParserIO() as buffer:
+# rows per record batch emitted while streaming
+DEF DEFAULT_BATCH_SIZE = 1 << 16
 
-        # buffer.seek(0)
-        # return _read_pg_buffer(buffer, field_names, field_types)
-    with io.BytesIO() as buffer:
-        cursor.copy_expert(query, buffer)
-        buffer.seek(0)
-        return _read_pg_buffer(buffer, field_names, field_types)
 
-
-def read_pg_query(cursor, query, field_names, field_types):
-    return _read_pg_query(cursor, query, field_names, field_types)
+cdef class StreamDecoder:
+    """
+    File-like sink for ``cursor.copy_expert`` which decodes COPY BINARY data as
+    it arrives instead of collecting the whole result first.
+
+    Each ``write`` decodes all complete tuples in the chunk (without the GIL);
+    a trailing partial tuple is kept and completed by the next chunk. Every
+    ``batch_size`` rows a RecordBatch is finished and either handed to
+    ``on_batch`` or kept until ``to_table``. With ``strings_as_dictionary``, a
+    text column switches from dictionary to plain strings from the batch in which
+    it has too many distinct values on, which ``to_table`` evens out.
+    """
+    cdef unique_ptr[CCopyDecoder] decoder
+    cdef bytearray pending
+    cdef int64_t batch_size
+    cdef object on_batch
+    cdef list batches
+    cdef bint closed
+    cdef bint retain_input
+
+    def __cinit__(self, field_names, field_types, batch_size=DEFAULT_BATCH_SIZE, on_batch=None,
+                  **options):
+        make_decoder(field_names, field_types, options, &self.decoder)
+        self.pending = bytearray()
+        self.batch_size = batch_size
+        self.on_batch = on_batch
+        self.batches = []
+        self.closed = False
+        self.retain_input = options.get('string_view', False)
+
+    @property
+    def schema(self):
+        return pyarrow_wrap_schema(self.decoder.get().schema())
+
+    cdef int64_t _decode(self, const unsigned char[::1] data) except -1:
+        cdef CStatus status
+        cdef int64_t consumed = 0
+        cdef int64_t pos = 0
+        cdef int64_t size = data.shape[0]
+        while pos < size:
+            with nogil:
+                status = self.decoder.get().decode(<const char*> &data[pos], size - pos,
+                                                   &consumed, self.batch_size)
+            check_status(status)
+            pos += consumed
+            if self.decoder.get().num_rows() < self.batch_size:
+                break
+            self._flush()
+        return pos
+
+    cdef _flush(self):
+        cdef shared_ptr[CRecordBatch] c_batch
+        check_status(self.decoder.get().flush(&c_batch))
+        batch = pyarrow_wrap_batch(c_batch)
+        if self.on_batch is not None:
+            self.on_batch(batch)
+        else:
+            self.batches.append(batch)
+
+    def write(self, data):
+        if self.closed:
+            raise ValueError('write to closed StreamDecoder')
+
+        size = len(data)
+        if self.retain_input:
+            # string views point into the chunks, which must stay unchanged
+            if self.pending or not isinstance(data, bytes):
+                data = bytes(self.pending + data)
+                self.pending.clear()
+            self.decoder.get().set_source(pyarrow_unwrap_buffer(pa.py_buffer(data)))
+
+        if self.pending:
+            # finish the partial tuple left over by the previous chunk
+            self.pending += data
+            consumed = self._decode(self.pending)
+            del self.pending[:consumed]
+        else:
+            consumed = self._decode(data)
+            if consumed < len(data):
+                self.pending += memoryview(data)[consumed:]
+        return size
+
+    def close(self):
+        """
+        Check the stream was complete and finish the last batch
+        """
+        if self.closed:
+            return
+        self.closed = True
+        if not self.decoder.get().finished() or self.pending:
+            raise pa.ArrowInvalid('COPY BINARY stream ended in the middle of the data')
+        if self.decoder.get().num_rows() > 0:
+            self._flush()
+
+    def to_table(self):
+        """
+        Close the stream and assemble the batches not handed to ``on_batch``
+        """
+        self.close()
+        cdef vector[shared_ptr[CRecordBatch]] c_batches
+        cdef shared_ptr[CTable] table
+        for batch in self.batches:
+            c_batches.push_back(pyarrow_unwrap_batch(batch))
+        check_status(self.decoder.get().make_table(c_batches, &table))
+        return pyarrow_wrap_table(table)
+
+
+COPY_QUERY_RE = re.compile(r'^\s*copy\s*\((.*)\)\s*to\s', re.IGNORECASE | re.DOTALL)
+COPY_TABLE_RE = re.compile(r'^\s*copy\s+([^\s(]+)', re.IGNORECASE)
+
+
+def estimate_query_rows(cursor, query):
+    """
+    Rows the server expects a COPY ... TO STDOUT statement to produce: the planner
+    estimate for COPY (query), pg_class.reltuples for COPY table. -1 if unknown.
+    """
+    match = COPY_QUERY_RE.match(query)
+    if match:
+        cursor.execute('EXPLAIN (FORMAT JSON) ' + match.group(1))
+        plan = cursor.fetchone()[0]
+        if isinstance(plan, str):
+            plan = json.loads(plan)
+        return int(plan[0]['Plan']['Plan Rows'])
+
+    match = COPY_TABLE_RE.match(query)
+    if match:
+        cursor.execute('SELECT reltuples FROM pg_class WHERE oid = to_regclass(%s)', (match.group(1),))
+        row = cursor.fetchone()
+        # never analyzed tables report -1 (0 before PG 14)
+        if row is not None and row[0] is not None and row[0] > 0:
+            return int(row[0])
+    return -1
+
+
+cdef _read_pg_query(cursor, query, field_names, field_types, options):
+    if 'expected_rows' not in options:
+        options = dict(options, expected_rows=estimate_query_rows(cursor, query))
+    enums, composites, ranges = resolve_types(cursor, field_types, options.get('enums', {}),
+                                              options.get('composites', {}), options.get('ranges', {}))
+    options = dict(options, enums=enums, composites=composites, ranges=ranges)
+    decoder = StreamDecoder(field_names, field_types, **options)
+    cursor.copy_expert(query, decoder)
+    return decoder.to_table()
+
+
+def read_pg_query(cursor, query, field_names, field_types, **options):
+    return _read_pg_query(cursor, query, field_names, field_types, options)
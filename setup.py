@@ -12,9 +12,11 @@ requirements = [
 ]
 
 
-os.environ['CFLAGS'] = '-std=c++11 -stdlib=libc++'
+# the native decoder is built against the Arrow C++ headers, which need C++20
+os.environ['CFLAGS'] = '-std=c++20'
 
 ext_modules = cythonize("pgarrow/*.pyx", annotate=True,
+                        include_path=['pgarrow'],
                         # compiler_directives={'language_level' : "3"},
 
 
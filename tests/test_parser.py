@@ -0,0 +1,1095 @@
+import datetime
+import decimal
+import gc
+import io
+import json
+import struct
+
+import pyarrow as pa
+import pytest
+
+from pgarrow import parser
+
+
+COPY_HEADER = b'PGCOPY\n\xff\r\n\x00' + struct.pack('!ii', 0, 0)
+COPY_TRAILER = struct.pack('!h', -1)
+
+
+def copy_binary(rows, formats):
+    """
+    Build a COPY BINARY payload, `formats` gives the struct format of each column
+    """
+    out = [COPY_HEADER]
+    for row in rows:
+        out.append(struct.pack('!h', len(row)))
+        for value, fmt in zip(row, formats):
+            if value is None:
+                out.append(struct.pack('!i', -1))
+            else:
+                field = struct.pack('!' + fmt, value)
+                out.append(struct.pack('!i', len(field)) + field)
+    out.append(COPY_TRAILER)
+    return b''.join(out)
+
+
+def pg_timestamp(dt):
+    return int((dt - datetime.datetime(2000, 1, 1)) / datetime.timedelta(microseconds=1))
+
+
+def pg_interval(microseconds, days, months):
+    return struct.pack('!qii', microseconds, days, months)
+
+
+def test_read_fixed_width():
+    rows = [(1, 2, 3, 1.5, 2.5), (-1, -2, -3, -1.5, -2.5)]
+    data = copy_binary(rows, ['h', 'i', 'q', 'f', 'd'])
+    names = ['a', 'b', 'c', 'd', 'e']
+    table = parser.read_pg_buffer(io.BytesIO(data), names, ['int2', 'int4', 'int8', 'float4', 'float8'])
+
+    assert table.schema.types == [pa.int16(), pa.int32(), pa.int64(), pa.float32(), pa.float64()]
+    assert table.to_pylist() == [dict(zip(names, r)) for r in rows]
+
+
+def test_read_nulls():
+    data = copy_binary([(1, None), (None, 2.0)], ['q', 'd'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a', 'b'], ['int8', 'float8'])
+
+    assert table.column('a').to_pylist() == [1, None]
+    assert table.column('b').to_pylist() == [None, 2.0]
+
+
+@pytest.mark.parametrize('num_rows', [1, 7, 31, 67, 1000])
+def test_read_fixed_width_bulk(num_rows):
+    # row counts straddling the vector widths of the byte swap kernels
+    rows = [(i - 500, None if i % 5 == 0 else i * 70000, -i * 1 << 40, i / 4, -i / 8)
+            for i in range(num_rows)]
+    data = copy_binary(rows, ['h', 'i', 'q', 'f', 'd'])
+    names = ['a', 'b', 'c', 'd', 'e']
+    table = parser.read_pg_buffer(io.BytesIO(data), names, ['int2', 'int4', 'int8', 'float4', 'float8'],
+                                  parallel='columns')
+
+    assert table.to_pylist() == [dict(zip(names, r)) for r in rows]
+    assert table.column('b').null_count == (num_rows + 4) // 5
+
+
+@pytest.mark.parametrize('first_null', [0, 63, 64, 65, 1000])
+def test_validity_bitmap(first_null):
+    rows = [(i, None if i >= first_null and i % 3 == 0 else i) for i in range(1100)]
+    data = copy_binary(rows, ['q', 'q'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a', 'b'], ['int8', 'int8'])
+    a, b = table.column('a').chunk(0), table.column('b').chunk(0)
+    b.validate(full=True)
+
+    # columns without NULLs carry no bitmap at all
+    assert a.buffers()[0] is None
+    assert b.null_count == sum(r[1] is None for r in rows)
+    assert b.to_pylist() == [r[1] for r in rows]
+
+
+def test_read_timestamp():
+    dt = datetime.datetime(2017, 3, 4, 5, 6, 7, 89)
+    data = copy_binary([(pg_timestamp(dt),)], ['q'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['ts'], ['timestamp'])
+
+    assert table.column('ts').to_pylist() == [dt]
+
+
+def test_read_temporal():
+    dt = datetime.datetime(1969, 7, 20, 20, 17, 40, 123456)
+    day = datetime.date(1969, 7, 20)
+    tod = datetime.time(20, 17, 40, 123456)
+    rows = [(pg_timestamp(dt), pg_timestamp(dt), (day - datetime.date(2000, 1, 1)).days,
+             pg_timestamp(datetime.datetime.combine(datetime.date(2000, 1, 1), tod)))] * 70
+    data = copy_binary(rows, ['q', 'q', 'i', 'q'])
+    names = ['ts', 'tstz', 'd', 't']
+    table = parser.read_pg_buffer(io.BytesIO(data), names, ['timestamp', 'timestamptz', 'date', 'time'],
+                                  timezone='Europe/Paris')
+
+    assert table.schema.types == [pa.timestamp('us'), pa.timestamp('us', 'Europe/Paris'), pa.date32(),
+                                  pa.time64('us')]
+    assert table.column('ts').to_pylist() == [dt] * 70
+    assert table.column('tstz').cast(pa.timestamp('us')).to_pylist() == [dt] * 70
+    assert table.column('d').to_pylist() == [day] * 70
+    assert table.column('t').to_pylist() == [tod] * 70
+
+
+def test_read_timestamp_ns():
+    dt = datetime.datetime(2017, 3, 4, 5, 6, 7, 89)
+    data = copy_binary([(pg_timestamp(dt), pg_timestamp(dt))], ['q', 'q'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['ts', 't'], ['timestamp', 'time'], time_unit='ns')
+
+    assert table.schema.types == [pa.timestamp('ns'), pa.time64('ns')]
+    assert table.column('ts').cast(pa.int64()).to_pylist() == [1488603967000089000]
+
+
+@pytest.mark.parametrize('infinity, expected', [
+    ('extremes', [2 ** 63 - 1, -2 ** 63, 2 ** 31 - 1, -2 ** 31]),
+    ('datetime', [253402300799999999, -62135596800000000, 2932896, -719162]),
+    ('null', [None] * 4),
+])
+def test_read_infinity(infinity, expected):
+    rows = [(2 ** 63 - 1, 2 ** 31 - 1), (-2 ** 63, -2 ** 31), (0, 0)]
+    data = copy_binary(rows, ['q', 'i'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['ts', 'd'], ['timestamp', 'date'], infinity=infinity)
+
+    assert table.column('ts').cast(pa.int64()).to_pylist() == expected[:2] + [946684800000000]
+    assert table.column('d').cast(pa.int32()).to_pylist() == expected[2:] + [10957]
+
+
+def test_read_timestamp_overflow():
+    # year 3000 does not fit int64 nanoseconds
+    rows = [(pg_timestamp(datetime.datetime(3000, 1, 1)),), (0,)]
+    data = copy_binary(rows, ['q'])
+    with pytest.raises(pa.ArrowInvalid, match='out of range'):
+        parser.read_pg_buffer(io.BytesIO(data), ['ts'], ['timestamp'], time_unit='ns')
+
+    table = parser.read_pg_buffer(io.BytesIO(data), ['ts'], ['timestamp'], time_unit='ns',
+                                  time_overflow='null')
+    assert table.column('ts').cast(pa.int64()).to_pylist() == [None, 946684800000000000]
+
+
+def test_read_interval():
+    # 1 year 2 months 3 days 04:05:06.000007, and its negation
+    rows = [(pg_interval(14706000007, 3, 14),), (pg_interval(-14706000007, -3, -14),), (None,)] * 30
+    data = copy_binary(rows, ['16s'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['i'], ['interval'])
+
+    assert table.schema.types == [pa.month_day_nano_interval()]
+    assert table.column('i').to_pylist() == [
+        pa.MonthDayNano([14, 3, 14706000007000]), pa.MonthDayNano([-14, -3, -14706000007000]), None] * 30
+
+
+def test_read_interval_overflow():
+    # 300 years of hours do not fit int64 nanoseconds
+    rows = [(pg_interval(300 * 366 * 24 * 3600 * 10 ** 6, 0, 0),), (pg_interval(1, 0, 0),)]
+    data = copy_binary(rows, ['16s'])
+    with pytest.raises(pa.ArrowInvalid, match='out of range'):
+        parser.read_pg_buffer(io.BytesIO(data), ['i'], ['interval'])
+
+    table = parser.read_pg_buffer(io.BytesIO(data), ['i'], ['interval'], time_overflow='null')
+    assert table.column('i').to_pylist() == [None, pa.MonthDayNano([0, 0, 1000])]
+
+
+def test_read_file(tmp_path):
+    path = tmp_path / 'test.pgdat'
+    path.write_bytes(copy_binary([(i,) for i in range(1000)], ['q']))
+    table = parser.read_pg_file(str(path), ['a'], ['int8'])
+
+    assert table.column('a').to_pylist() == list(range(1000))
+
+
+def test_truncated_buffer():
+    data = copy_binary([(1,), (2,)], ['q'])
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_buffer(io.BytesIO(data[:-5]), ['a'], ['int8'])
+
+
+def test_bad_signature():
+    data = copy_binary([(1,)], ['q'])
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_buffer(io.BytesIO(b'X' + data[1:]), ['a'], ['int8'])
+
+
+def test_wrong_field_count():
+    data = copy_binary([(1, 2)], ['q', 'q'])
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_buffer(io.BytesIO(data), ['a'], ['int8'])
+
+
+@pytest.mark.parametrize('chunk_size', [1, 7, 64, 1 << 20])
+def test_stream_decoder(chunk_size):
+    rows = [(i, float(i) / 2) for i in range(500)]
+    data = copy_binary(rows, ['q', 'd'])
+    decoder = parser.StreamDecoder(['a', 'b'], ['int8', 'float8'], batch_size=100)
+    for start in range(0, len(data), chunk_size):
+        decoder.write(data[start:start + chunk_size])
+    table = decoder.to_table()
+
+    assert table.column('a').to_pylist() == [r[0] for r in rows]
+    assert table.column('b').to_pylist() == [r[1] for r in rows]
+    assert all(len(chunk) <= 100 for chunk in table.column('a').chunks)
+
+
+@pytest.mark.parametrize('null_every', [1, 2, 1000, 40000, None])
+def test_fixed_stride(null_every):
+    # long NULL-free runs use the strided path, the rows with a NULL the general one
+    rows = [(i, None if null_every and i % null_every == 0 else i * 0.25, -i, i % 300)
+            for i in range(40000)]
+    data = copy_binary(rows, ['q', 'd', 'i', 'h'])
+    names = ['a', 'b', 'c', 'd']
+    table = parser.read_pg_buffer(io.BytesIO(data), names, ['int8', 'float8', 'int4', 'int2'])
+
+    assert table.to_pylist() == [dict(zip(names, r)) for r in rows]
+
+
+def test_fixed_stride_bad_length():
+    data = bytearray(copy_binary([(i,) for i in range(100)], ['q']))
+    # shrink the 50th field to 4 bytes without changing the stream length
+    pos = len(COPY_HEADER) + 49 * 14 + 2
+    data[pos:pos + 4] = struct.pack('!i', 4)
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_buffer(io.BytesIO(bytes(data)), ['a'], ['int8'])
+
+
+@pytest.mark.parametrize('expected_rows', [0, 10, 500, 100000])
+def test_expected_rows(expected_rows):
+    # a wrong estimate only costs memory or reallocations, never rows
+    rows = [(i, None if i % 9 == 0 else float(i)) for i in range(500)]
+    data = copy_binary(rows, ['q', 'd'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a', 'b'], ['int8', 'float8'],
+                                  expected_rows=expected_rows)
+    assert table.column('b').to_pylist() == [r[1] for r in rows]
+
+    decoder = parser.StreamDecoder(['a', 'b'], ['int8', 'float8'], batch_size=128,
+                                   expected_rows=expected_rows)
+    decoder.write(data)
+    assert decoder.to_table().equals(table)
+
+
+def test_stream_decoder_on_batch():
+    data = copy_binary([(i,) for i in range(250)], ['q'])
+    batches = []
+    decoder = parser.StreamDecoder(['a'], ['int8'], batch_size=100, on_batch=batches.append)
+    decoder.write(data)
+    decoder.close()
+
+    assert sum(b.num_rows for b in batches) == 250
+
+
+def test_stream_decoder_truncated():
+    data = copy_binary([(1,), (2,)], ['q'])
+    decoder = parser.StreamDecoder(['a'], ['int8'])
+    decoder.write(data[:-3])
+    with pytest.raises(pa.ArrowInvalid):
+        decoder.close()
+
+
+def test_read_file_truncated(tmp_path):
+    path = tmp_path / 'test.pgdat'
+    path.write_bytes(copy_binary([(i,) for i in range(10)], ['q'])[:-1])
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_file(str(path), ['a'], ['int8'])
+
+
+def test_read_missing_file(tmp_path):
+    with pytest.raises(IOError):
+        parser.read_pg_file(str(tmp_path / 'missing.pgdat'), ['a'], ['int8'])
+
+
+@pytest.mark.parametrize('window_size', [1, 100, 1 << 26])
+def test_column_parallel(tmp_path, window_size):
+    rows = [(i, None if i % 7 == 0 else i * 1.5, -i) for i in range(2000)]
+    data = copy_binary(rows, ['q', 'd', 'i'])
+    names = ['a', 'b', 'c']
+    types = ['int8', 'float8', 'int4']
+    expected = parser.read_pg_buffer(io.BytesIO(data), names, types, use_threads=False)
+    table = parser.read_pg_buffer(io.BytesIO(data), names, types, use_threads=True,
+                                  window_size=window_size)
+    assert table.equals(expected)
+
+    path = tmp_path / 'test.pgdat'
+    path.write_bytes(data)
+    table = parser.read_pg_file(str(path), names, types, window_size=window_size)
+    assert table.equals(expected)
+    assert table.column('b').null_count == 286
+
+
+@pytest.mark.parametrize('window_size', [100, 1 << 26])
+def test_column_parallel_fixed_width(window_size):
+    # a text column keeps the fixed width columns off the strided path, so
+    # they are decoded from the index
+    rows = [(i - 500, None if i % 5 == 0 else i * 70000, -i << 40, i / 4, None if i % 3 == 0 else -i / 8,
+             b'v%05d' % i) for i in range(1000)]
+    data = copy_binary(rows, ['h', 'i', 'q', 'f', 'd', '6s'])
+    names = ['a', 'b', 'c', 'd', 'e', 's']
+    types = ['int2', 'int4', 'int8', 'float4', 'float8', 'text']
+    expected = parser.read_pg_buffer(io.BytesIO(data), names, types, use_threads=False)
+    table = parser.read_pg_buffer(io.BytesIO(data), names, types, parallel='columns', window_size=window_size)
+
+    assert table.equals(expected)
+    assert table.to_pylist() == [dict(zip(names, r[:5] + (r[5].decode(),))) for r in rows]
+    assert table.column('b').null_count == 200
+
+
+def test_unknown_option():
+    with pytest.raises(TypeError):
+        parser.read_pg_buffer(io.BytesIO(copy_binary([], [])), [], [], bogus=1)
+
+
+@pytest.mark.parametrize('chunk_size', [7, 33, 1000, 1 << 24])
+def test_chunk_parallel(tmp_path, chunk_size):
+    # lengths that also look like valid field counts and lengths, to trip up the resync
+    rows = [(3, None if i % 5 == 0 else 0x00030000 + i, 8) for i in range(3000)]
+    data = copy_binary(rows, ['h', 'q', 'i'])
+    names = ['a', 'b', 'c']
+    types = ['int2', 'int8', 'int4']
+    expected = parser.read_pg_buffer(io.BytesIO(data), names, types, use_threads=False)
+    table = parser.read_pg_buffer(io.BytesIO(data), names, types, parallel='chunks',
+                                  chunk_size=chunk_size)
+    assert table.equals(expected)
+
+    path = tmp_path / 'test.pgdat'
+    path.write_bytes(data)
+    table = parser.read_pg_file(str(path), names, types, parallel='chunks', chunk_size=chunk_size)
+    assert table.equals(expected)
+
+
+def test_chunk_parallel_truncated():
+    data = copy_binary([(i,) for i in range(1000)], ['q'])
+    with pytest.raises(pa.ArrowInvalid):
+        parser.read_pg_buffer(io.BytesIO(data[:-2]), ['a'], ['int8'], parallel='chunks', chunk_size=100)
+
+
+class FakeCursor:
+    def __init__(self, result):
+        self.result = result
+        self.executed = []
+
+    def execute(self, sql, params=None):
+        self.executed.append((sql, params))
+
+    def fetchone(self):
+        return self.result
+
+    def fetchall(self):
+        return self.result
+
+
+def test_estimate_query_rows():
+    cursor = FakeCursor(([{'Plan': {'Plan Rows': 1234}}],))
+    query = 'COPY (SELECT * FROM edrp_edf.elec_daily) TO STDOUT WITH (FORMAT BINARY)'
+    assert parser.estimate_query_rows(cursor, query) == 1234
+    assert cursor.executed == [('EXPLAIN (FORMAT JSON) SELECT * FROM edrp_edf.elec_daily', None)]
+
+    cursor = FakeCursor((5678.0,))
+    assert parser.estimate_query_rows(cursor, 'COPY edrp_edf.elec_daily TO STDOUT (FORMAT BINARY)') == 5678
+    assert cursor.executed[0][1] == ('edrp_edf.elec_daily',)
+
+    assert parser.estimate_query_rows(FakeCursor((-1.0,)), 'copy t to stdout') == -1
+
+
+def test_arena_memory_pool():
+    pool = parser.ArenaMemoryPool(arena_size=4 << 20)
+    rows = [(i, None if i % 11 == 0 else i * 0.5) for i in range(200000)]
+    data = copy_binary(rows, ['q', 'd'])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a', 'b'], ['int8', 'float8'], memory_pool=pool)
+
+    assert table.column('b').to_pylist() == [r[1] for r in rows]
+    assert pool.bytes_allocated() >= 200000 * 16
+    assert pool.max_memory() >= pool.bytes_allocated()
+    assert pool.mapped_bytes >= pool.bytes_allocated()
+    assert 0 <= pool.fragmentation < 1
+
+    del table
+    assert pool.bytes_allocated() == 0
+
+
+def test_arena_memory_pool_outlived_by_buffers():
+    pool = parser.ArenaMemoryPool(arena_size=2 << 20)
+    small = pa.allocate_buffer(1000, memory_pool=pool)
+    large = pa.allocate_buffer(1 << 20, memory_pool=pool)
+    memoryview(small).cast('B')[:4] = b'abcd'
+    del pool
+    gc.collect()
+
+    # the pool goes with the last of its buffers
+    assert small.to_pybytes()[:4] == b'abcd'
+    del small, large
+    gc.collect()
+
+
+def test_arena_memory_pool_resize():
+    pool = parser.ArenaMemoryPool(arena_size=2 << 20)
+    small = [pa.allocate_buffer(1000, memory_pool=pool, resizable=True) for _ in range(100)]
+    for i, buf in enumerate(small):
+        # grow across the large buffer threshold and back, keeping the contents
+        memoryview(buf).cast('B')[:4] = i.to_bytes(4, 'little')
+        buf.resize(1 << 20)
+        buf.resize(100, shrink_to_fit=True)
+        assert buf.to_pybytes()[:4] == i.to_bytes(4, 'little')
+    # capacities are padded to 64 bytes
+    assert pool.bytes_allocated() == 100 * 128
+
+    del small, buf
+    pool.release_unused()
+    assert pool.bytes_allocated() == 0
+    assert pool.mapped_bytes == 0
+
+
+def test_arena_size_must_be_power_of_two():
+    with pytest.raises(pa.ArrowInvalid):
+        parser.ArenaMemoryPool(arena_size=3 << 20)
+
+
+def copy_text(rows):
+    """
+    Build a COPY BINARY payload of text/bytea columns from bytes values
+    """
+    out = [COPY_HEADER]
+    for row in rows:
+        out.append(struct.pack('!h', len(row)))
+        for value in row:
+            if value is None:
+                out.append(struct.pack('!i', -1))
+            else:
+                out.append(struct.pack('!i', len(value)) + value)
+    out.append(COPY_TRAILER)
+    return b''.join(out)
+
+
+TEXT_ROWS = [('short', b'\x00\x01'), (None, b''), ('a string longer than twelve bytes', None),
+             ('ünïcödé ' * 10, b'\xff' * 40)] * 50
+
+
+@pytest.mark.parametrize('string_view', [False, True])
+def test_read_text(tmp_path, string_view):
+    data = copy_text([(None if s is None else s.encode('utf8'), b) for s, b in TEXT_ROWS])
+    names = ['s', 'b']
+    types = ['text', 'bytea']
+    table = parser.read_pg_buffer(io.BytesIO(data), names, types, string_view=string_view)
+
+    expected_types = [pa.string_view(), pa.binary_view()] if string_view else [pa.string(), pa.binary()]
+    assert table.schema.types == expected_types
+    assert table.to_pylist() == [dict(zip(names, r)) for r in TEXT_ROWS]
+
+    path = tmp_path / 'test.pgdat'
+    path.write_bytes(data)
+    for parallel in ['columns', 'chunks']:
+        table = parser.read_pg_file(str(path), names, types, string_view=string_view,
+                                    parallel=parallel, chunk_size=1000, window_size=1000)
+        assert table.to_pylist() == [dict(zip(names, r)) for r in TEXT_ROWS]
+
+
+def test_string_view_references_input():
+    data = copy_text([(b'x' * 100,)] * 10)
+    table = parser.read_pg_buffer(io.BytesIO(data), ['s'], ['varchar'], string_view=True)
+    chunk = table.column('s').chunk(0)
+    # the values buffer is a slice of the input, not a copy
+    assert chunk.buffers()[2].address >= pa.py_buffer(data).address
+    del data
+    assert chunk.to_pylist() == ['x' * 100] * 10
+
+
+@pytest.mark.parametrize('chunk_size', [1, 50, 1 << 20])
+def test_stream_decoder_string_view(chunk_size):
+    rows = [(('value %d ' % i * (i % 5)).encode(),) for i in range(300)]
+    data = copy_text(rows)
+    decoder = parser.StreamDecoder(['s'], ['text'], batch_size=64, string_view=True)
+    for start in range(0, len(data), chunk_size):
+        decoder.write(bytearray(data[start:start + chunk_size]))
+    table = decoder.to_table()
+
+    assert table.column('s').to_pylist() == [r[0].decode() for r in rows]
+
+
+STATUSES = ['new', 'open', 'closed', 'a status name longer than sixteen bytes', None]
+
+
+@pytest.mark.parametrize('parallel', ['columns', 'chunks'])
+def test_strings_as_dictionary(parallel):
+    rows = [(STATUSES[i % 5], i) for i in range(5000)]
+    data = copy_text([(None if s is None else s.encode(), struct.pack('!q', i)) for s, i in rows])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['s', 'i'], ['text', 'int8'], strings_as_dictionary=True,
+                                  parallel=parallel, chunk_size=1000)
+
+    assert table.schema.field('s').type == pa.dictionary(pa.int32(), pa.utf8())
+    for chunk in table.column('s').chunks:
+        chunk.validate(full=True)
+        assert len(chunk.dictionary) <= 4
+    assert table.column('s').to_pylist() == [s for s, _ in rows]
+
+
+@pytest.mark.parametrize('parallel', ['columns', 'chunks'])
+def test_strings_as_dictionary_fallback(parallel):
+    # low cardinality in the first rows, unique values after
+    values = [STATUSES[i % 5] if i < 3000 else 'value %d' % i for i in range(20000)]
+    data = copy_text([(None if s is None else s.encode(),) for s in values])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['s'], ['text'], strings_as_dictionary=True,
+                                  dictionary_max_size=1000, parallel=parallel, chunk_size=10000)
+
+    assert table.schema.field('s').type == pa.utf8()
+    assert table.column('s').to_pylist() == values
+
+
+def test_stream_decoder_dictionary_fallback():
+    values = ['a', 'b'] * 500 + ['value %d' % i for i in range(2000)]
+    data = copy_text([(s.encode(),) for s in values])
+    batches = []
+    decoder = parser.StreamDecoder(['s'], ['text'], batch_size=1000, strings_as_dictionary=True,
+                                   dictionary_max_size=100, on_batch=batches.append)
+    decoder.write(data)
+    decoder.close()
+
+    # the first batch is still encoded, the following ones have given up
+    assert [b.schema.field('s').type for b in batches] == [pa.dictionary(pa.int32(), pa.utf8())] + [pa.utf8()] * 2
+
+    decoder = parser.StreamDecoder(['s'], ['text'], batch_size=1000, strings_as_dictionary=True,
+                                   dictionary_max_size=100)
+    decoder.write(data)
+    table = decoder.to_table()
+    assert table.schema.field('s').type == pa.utf8()
+    assert table.column('s').to_pylist() == values
+
+
+MOODS = ['sad', 'ok', 'happy']
+
+
+def test_read_enum():
+    values = ['happy', None, 'sad', 'ok', 'happy'] * 100
+    data = copy_text([(None if v is None else v.encode(), v and v.encode()) for v in values])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['m', 't'], ['mood', 'text'], enums={'mood': MOODS})
+
+    column = table.column('m')
+    assert column.type == pa.dictionary(pa.int16(), pa.utf8(), ordered=True)
+    chunk = column.chunk(0)
+    chunk.validate(full=True)
+    # the dictionary is the catalog order, not the order of appearance
+    assert chunk.dictionary.to_pylist() == MOODS
+    assert column.to_pylist() == values
+    assert table.column('t').type == pa.utf8()
+
+
+def test_read_enum_unknown_label():
+    data = copy_text([(b'ok',), (b'furious',)])
+    with pytest.raises(pa.ArrowInvalid, match='furious'):
+        parser.read_pg_buffer(io.BytesIO(data), ['m'], ['mood'], enums={'mood': MOODS})
+
+
+def test_load_enum_labels():
+    cursor = FakeCursor([('mood', MOODS)])
+    assert parser.load_enum_labels(cursor, ['mood']) == {'mood': MOODS}
+    assert cursor.executed[0][1] == (['mood'],)
+
+
+def pg_numeric(value):
+    """
+    Send format of a numeric, from a decimal.Decimal (or 'NaN')
+    """
+    if value == 'NaN':
+        return struct.pack('!hhHh', 0, 0, 0xC000, 0)
+    sign, digits, exponent = value.as_tuple()
+    # pad to whole base-10000 digits on both sides of the point
+    digits = ''.join(map(str, digits))
+    frac = max(-exponent, 0)
+    digits += '0' * max(exponent, 0) + '0' * (-frac % 4)
+    int_len = len(digits) - frac - (-frac % 4)
+    digits = '0' * (-int_len % 4) + digits
+    groups = [int(digits[i:i + 4]) for i in range(0, len(digits), 4)]
+    weight = (int_len + 3) // 4 - 1
+    while groups and groups[0] == 0:
+        groups.pop(0)
+        weight -= 1
+    while groups and groups[-1] == 0:
+        groups.pop()
+    return struct.pack('!hhHh%dh' % len(groups), len(groups), weight if groups else 0,
+                       0x4000 if sign else 0, frac, *groups)
+
+
+NUMERICS = ['0', '1', '-1', '123.45', '-0.01', '99999999.99', '0.005', '1e20', '-12345678901234567890.12']
+
+
+@pytest.mark.parametrize('field_type, precision, scale', [('numeric(30, 2)', 30, 2), ('numeric(60,2)', 60, 2),
+                                                          ('numeric', 38, 2)])
+def test_read_numeric(field_type, precision, scale):
+    values = [decimal.Decimal(v) for v in NUMERICS] + [None]
+    data = copy_text([(None if v is None else pg_numeric(v),) for v in values])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['n'], [field_type], numeric_scale=2)
+
+    expected_type = pa.decimal128(precision, scale) if precision <= 38 else pa.decimal256(precision, scale)
+    assert table.column('n').type == expected_type
+    q = decimal.Decimal('0.01')
+    # rounded half away from zero to the scale, like PG
+    assert table.column('n').to_pylist() == [None if v is None else v.quantize(q, decimal.ROUND_HALF_UP)
+                                             for v in values]
+
+
+def test_numeric_overflow():
+    data = copy_text([(pg_numeric(decimal.Decimal('12.5')),), (pg_numeric(decimal.Decimal('1234.5')),)])
+    with pytest.raises(pa.ArrowInvalid, match='does not fit'):
+        parser.read_pg_buffer(io.BytesIO(data), ['n'], ['numeric(4, 1)'])
+
+    table = parser.read_pg_buffer(io.BytesIO(data), ['n'], ['numeric(4, 1)'], numeric_overflow='null')
+    assert table.column('n').to_pylist() == [decimal.Decimal('12.5'), None]
+
+
+def test_numeric_nan():
+    data = copy_text([(pg_numeric('NaN'),), (pg_numeric(decimal.Decimal('1.5')),)])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['n'], ['numeric(10, 2)'])
+    assert table.column('n').to_pylist() == [None, decimal.Decimal('1.50')]
+
+    with pytest.raises(pa.ArrowInvalid, match='NaN'):
+        parser.read_pg_buffer(io.BytesIO(data), ['n'], ['numeric(10, 2)'], numeric_special='error')
+
+
+def pg_array(element_oid, elements, ndim=1):
+    """
+    Send format of a 1-D array from the send formats of its elements (None for NULL)
+    """
+    header = struct.pack('!iiI', ndim, any(e is None for e in elements), element_oid)
+    if ndim:
+        header += struct.pack('!ii', len(elements), 1)
+    return header + b''.join(struct.pack('!i', -1) if e is None else struct.pack('!i', len(e)) + e
+                             for e in elements)
+
+
+FLOAT8_ARRAYS = [[1.5, -2.5, 3.0], [], None, [None, 4.0], list(map(float, range(100)))] * 20
+
+
+@pytest.mark.parametrize('large_lists', [False, True])
+def test_read_float8_array(large_lists):
+    data = copy_text([(None if a is None else pg_array(701, [None if v is None else struct.pack('!d', v)
+                                                              for v in a]),) for a in FLOAT8_ARRAYS])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a'], ['float8[]'], large_lists=large_lists)
+    table.validate(full=True)
+
+    assert table.column('a').type == (pa.large_list if large_lists else pa.list_)(pa.float64())
+    assert table.column('a').to_pylist() == FLOAT8_ARRAYS
+
+
+def test_read_text_array():
+    arrays = [['a', None, 'ünïcödé'], [], None] * 10
+    data = copy_text([(None if a is None else pg_array(25, [None if v is None else v.encode('utf8') for v in a]),)
+                      for a in arrays])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a'], ['text[]'], parallel='columns')
+
+    assert table.column('a').type == pa.list_(pa.utf8())
+    assert table.column('a').to_pylist() == arrays
+
+
+def test_read_empty_array():
+    # PG sends empty arrays without dimensions
+    data = copy_text([(pg_array(23, [], ndim=0),), (pg_array(23, [struct.pack('!i', 7)]),)])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a'], ['int4[]'])
+    assert table.column('a').to_pylist() == [[], [7]]
+
+
+def test_read_array_errors():
+    data = copy_text([(pg_array(700, [struct.pack('!f', 1.0)]),)])
+    with pytest.raises(pa.ArrowInvalid, match='element type oid 700'):
+        parser.read_pg_buffer(io.BytesIO(data), ['a'], ['int4[]'])
+
+    data = copy_text([(pg_array(23, [struct.pack('!i', 7)])[:-1],)])
+    with pytest.raises(pa.ArrowInvalid, match='corrupt array'):
+        parser.read_pg_buffer(io.BytesIO(data), ['a'], ['int4[]'])
+
+    # the product of these dimensions overflows int64
+    huge = struct.pack('!iiI', 6, 0, 23) + struct.pack('!ii', 2 ** 31 - 1, 1) * 6 + struct.pack('!i', 4) * 8
+    with pytest.raises(pa.ArrowInvalid, match='corrupt array'):
+        parser.read_pg_buffer(io.BytesIO(copy_text([(huge,)])), ['a'], ['int4[]'])
+
+
+def pg_vector(values):
+    return struct.pack('!HH%df' % len(values), len(values), 0, *values)
+
+
+@pytest.mark.parametrize('field_type', ['vector(3)', 'vector'])
+def test_read_pgvector(field_type):
+    vectors = [[0.5, -1.0, 2.0], None, [3.0, 4.0, 5.5]] * 40
+    data = copy_text([(None if v is None else pg_vector(v), struct.pack('!q', i)) for i, v in enumerate(vectors)])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['v', 'i'], [field_type, 'int8'])
+
+    assert table.column('v').type == pa.list_(pa.float32(), 3)
+    assert table.column('v').to_pylist() == vectors
+
+
+@pytest.mark.parametrize('parallel', ['columns', 'chunks'])
+def test_read_pgvector_late_shape(parallel):
+    # the shape is only known from values after the first chunks
+    vectors = [None] * 500 + [[float(i), 1.0, 2.0] for i in range(500)]
+    data = copy_text([(None if v is None else pg_vector(v), struct.pack('!q', i)) for i, v in enumerate(vectors)])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['v', 'i'], ['vector', 'int8'], parallel=parallel,
+                                  chunk_size=1000)
+    assert table.column('v').type == pa.list_(pa.float32(), 3)
+    assert table.column('v').to_pylist() == vectors
+
+    decoder = parser.StreamDecoder(['v', 'i'], ['vector', 'int8'], batch_size=100)
+    decoder.write(data)
+    table = decoder.to_table()
+    assert table.column('v').type == pa.list_(pa.float32(), 3)
+    assert table.column('v').to_pylist() == vectors
+
+
+def test_read_fixed_size_array():
+    arrays = [[1.0, 2.0, None, 4.0], None, [5.0, 6.0, 7.0, 8.0]] * 30
+    data = copy_text([(None if a is None else pg_array(700, [None if v is None else struct.pack('!f', v)
+                                                              for v in a]),) for a in arrays])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['a'], ['float4[4]'])
+    table.validate(full=True)
+
+    assert table.column('a').type == pa.list_(pa.float32(), 4)
+    assert table.column('a').to_pylist() == arrays
+
+
+def pg_array_2d(element_oid, fmt, rows):
+    header = struct.pack('!iiIiiii', 2, 0, element_oid, len(rows), 1, len(rows[0]), 1)
+    size = struct.calcsize('!' + fmt)
+    return header + b''.join(struct.pack('!i' + fmt, size, v) for row in rows for v in row)
+
+
+@pytest.mark.parametrize('field_type, options', [('float8[2][3]', {}), ('float8[]', {'fixed_size_arrays': True})])
+def test_read_tensor(field_type, options):
+    matrices = [None, [[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]], [[-1.0, 0.0, 1.0], [2.0, 3.0, 4.0]]]
+    data = copy_text([(None if m is None else pg_array_2d(701, 'd', m),) for m in matrices])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['m'], [field_type], **options)
+
+    column = table.column('m')
+    assert column.type.extension_name == 'arrow.fixed_shape_tensor'
+    assert column.type.shape == [2, 3]
+    assert column.chunk(0).storage.to_pylist() == [None if m is None else sum(m, []) for m in matrices]
+
+
+def test_read_fixed_size_array_wrong_shape():
+    data = copy_text([(pg_array(701, [struct.pack('!d', 1.0)] * 3),), (pg_array(701, [struct.pack('!d', 1.0)] * 2),)])
+    with pytest.raises(pa.ArrowInvalid, match=r'shape \[2\] in column .* of shape \[3\]'):
+        parser.read_pg_buffer(io.BytesIO(data), ['a'], ['float8[]'], fixed_size_arrays=True)
+
+
+def pg_record(attributes):
+    """
+    Send format of a composite from (type oid, send format or None) pairs
+    """
+    return struct.pack('!i', len(attributes)) + b''.join(
+        struct.pack('!Ii', oid, -1) if value is None else struct.pack('!Ii', oid, len(value)) + value
+        for oid, value in attributes)
+
+
+COMPOSITES = {
+    'reading': [('sensor', 'text'), ('at', 'int4'), ('values', 'float8[]'), ('site', 'site')],
+    'site': [('id', 'int8'), ('name', 'text')],
+}
+
+
+def test_read_composite():
+    def reading(sensor, at, values, site):
+        return pg_record([
+            (25, sensor.encode('utf8')), (23, struct.pack('!i', at)),
+            (1022, None if values is None else pg_array(701, [struct.pack('!d', v) for v in values])),
+            (0, None if site is None else pg_record([(20, struct.pack('!q', site[0])), (25, site[1].encode('utf8'))])),
+        ])
+
+    rows = [('a', 1, [1.5, 2.5], (7, 'north')), None, ('b', 2, None, None), ('c', 3, [], (8, 'south'))] * 20
+    data = copy_text([(None if r is None else reading(*r),) for r in rows])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['r'], ['reading'], composites=COMPOSITES, parallel='columns')
+    table.validate(full=True)
+
+    assert table.column('r').type == pa.struct([
+        ('sensor', pa.utf8()), ('at', pa.int32()), ('values', pa.list_(pa.float64())),
+        ('site', pa.struct([('id', pa.int64()), ('name', pa.utf8())]))])
+    assert table.column('r').to_pylist() == [
+        None if r is None else {'sensor': r[0], 'at': r[1], 'values': r[2],
+                                'site': None if r[3] is None else {'id': r[3][0], 'name': r[3][1]}}
+        for r in rows]
+
+
+def test_read_composite_errors():
+    data = copy_text([(pg_record([(23, struct.pack('!i', 1))]),)])
+    with pytest.raises(pa.ArrowInvalid, match='composite of 1 attributes'):
+        parser.read_pg_buffer(io.BytesIO(data), ['r'], ['site'], composites=COMPOSITES)
+
+    data = copy_text([(pg_record([(23, struct.pack('!i', 1)), (25, b'x')]),)])
+    with pytest.raises(pa.ArrowInvalid, match="attribute 'id' .* has type oid 23"):
+        parser.read_pg_buffer(io.BytesIO(data), ['r'], ['site'], composites=COMPOSITES)
+
+
+class QueuedCursor(FakeCursor):
+    def __init__(self, results):
+        super().__init__(None)
+        self.results = list(results)
+
+    def fetchall(self):
+        return self.results.pop(0)
+
+
+def composite_row(name, attributes):
+    """
+    Row of load_composite_attributes' query: the type name, attribute names and attribute types
+    """
+    return name, [a for a, _ in attributes], [t for _, t in attributes]
+
+
+def test_resolve_types():
+    cursor = QueuedCursor([
+        # enums, composites and ranges among reading, mood and span
+        [('mood', MOODS)], [composite_row('reading', [('sensor', 'text'), ('site', 'site'), ('m', 'mood[]')])],
+        [('span', 'float8')],
+        # then among the attribute types and subtypes
+        [], [composite_row('site', COMPOSITES['site'])], [],
+    ])
+    enums, composites, ranges = parser.resolve_types(cursor, ['reading', 'mood', 'span', 'int4', 'int8range'],
+                                                     {}, {}, {})
+
+    assert enums == {'mood': MOODS}
+    assert composites == {'reading': [('sensor', 'text'), ('site', 'site'), ('m', 'mood[]')],
+                          'site': COMPOSITES['site']}
+    assert ranges == {'span': 'float8'}
+    assert [sorted(params[0]) for _, params in cursor.executed] == [['mood', 'reading', 'span']] * 3 + [['site']] * 3
+
+
+def pg_range(fmt, lower=None, upper=None, flags=0):
+    """
+    Send format of a range; a bound of None is infinite unless the range is empty
+    """
+    if lower is None:
+        flags |= 0x08
+    if upper is None:
+        flags |= 0x10
+    out = struct.pack('!B', flags)
+    for bound in (lower, upper):
+        if bound is not None:
+            value = struct.pack('!' + fmt, bound)
+            out += struct.pack('!i', len(value)) + value
+    return out
+
+
+def test_read_range():
+    ranges = [pg_range('i', 1, 10, 0x02), pg_range('i', None, 5), pg_range('i', 3, None, 0x02 | 0x04),
+              struct.pack('!B', 0x01), None]
+    stamps = [pg_range('q', pg_timestamp(datetime.datetime(2024, 5, 1, 12)),
+                       pg_timestamp(datetime.datetime(2024, 5, 1, 14)), 0x02)] * 5
+    data = copy_text(list(zip(ranges, stamps, [pg_range('d', 0.5, 1.5, 0x02)] * 5)))
+    table = parser.read_pg_buffer(io.BytesIO(data), ['r', 'ts', 'f'], ['int4range', 'tsrange', 'span'],
+                                  ranges={'span': 'float8'})
+    table.validate(full=True)
+
+    def struct_type(subtype):
+        return pa.struct([('lower', subtype), ('upper', subtype), pa.field('lower_inclusive', pa.bool_(), False),
+                          pa.field('upper_inclusive', pa.bool_(), False), pa.field('empty', pa.bool_(), False)])
+
+    assert table.schema.types == [struct_type(pa.int32()), struct_type(pa.timestamp('us')), struct_type(pa.float64())]
+
+    def bounds(lower, upper, lower_inclusive=False, upper_inclusive=False, empty=False):
+        return {'lower': lower, 'upper': upper, 'lower_inclusive': lower_inclusive,
+                'upper_inclusive': upper_inclusive, 'empty': empty}
+
+    assert table.column('r').to_pylist() == [bounds(1, 10, True), bounds(None, 5), bounds(3, None, True, True),
+                                             bounds(None, None, empty=True), None]
+    assert table.column('ts').to_pylist() == [bounds(datetime.datetime(2024, 5, 1, 12),
+                                                     datetime.datetime(2024, 5, 1, 14), True)] * 5
+    assert table.column('f').to_pylist() == [bounds(0.5, 1.5, True)] * 5
+
+
+def test_read_uuid_macaddr_tid():
+    import uuid
+    ids = [uuid.uuid4() for _ in range(70)]
+    rows = [(u.bytes, None if i % 7 == 0 else bytes(range(i, i + 6)), struct.pack('!IH', 2 ** 32 - 1 - i, i))
+            for i, u in enumerate(ids)]
+    data = copy_text(rows)
+    table = parser.read_pg_buffer(io.BytesIO(data), ['u', 'm', 't'], ['uuid', 'macaddr', 'tid'])
+
+    assert table.schema.types == [pa.binary(16), pa.binary(6),
+                                  pa.struct([pa.field('block', pa.uint32(), False),
+                                             pa.field('offset', pa.uint16(), False)])]
+    assert table.column('u').to_pylist() == [u.bytes for u in ids]
+    assert table.column('m').to_pylist() == [r[1] for r in rows]
+    assert table.column('t').to_pylist() == [{'block': 2 ** 32 - 1 - i, 'offset': i} for i in range(70)]
+
+
+def test_read_inet():
+    import ipaddress
+    addresses = [ipaddress.ip_interface('192.168.1.7/24'), ipaddress.ip_interface('2001:db8::1/64'), None]
+
+    def pg_inet(interface, is_cidr=0):
+        packed = interface.ip.packed
+        family = 2 if interface.version == 4 else 3
+        return struct.pack('!BBBB', family, interface.network.prefixlen, is_cidr, len(packed)) + packed
+
+    data = copy_text([(None if a is None else pg_inet(a), None if a is None else pg_inet(a, 1))
+                      for a in addresses])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['i', 'c'], ['inet', 'cidr'])
+
+    expected = [None if a is None else
+                {'family': a.version, 'prefix_length': a.network.prefixlen,
+                 'address': (a.ip if a.version == 6 else ipaddress.IPv6Address('::ffff:' + str(a.ip))).packed}
+                for a in addresses]
+    assert table.column('i').to_pylist() == expected
+    assert table.column('c').to_pylist() == expected
+
+
+EVENTS = [{'kind': 'click', 'x': 10, 'tags': ['a', 'b']}, None, {'kind': 'view', 'x': None, 'extra': True},
+          {'kind': 'scroll\nline', 'x': -3}] * 25
+
+
+def json_rows(jsonb):
+    version = b'\x01' if jsonb else b''
+    return [(None if e is None else version + json.dumps(e, indent=1).encode(),) for e in EVENTS]
+
+
+@pytest.mark.parametrize('field_type', ['json', 'jsonb'])
+@pytest.mark.parametrize('large_strings', [False, True])
+def test_read_json(field_type, large_strings):
+    data = copy_text(json_rows(field_type == 'jsonb'))
+    table = parser.read_pg_buffer(io.BytesIO(data), ['e'], [field_type], large_strings=large_strings)
+
+    assert table.schema.types == [pa.large_utf8() if large_strings else pa.utf8()]
+    assert [None if s is None else json.loads(s) for s in table.column('e').to_pylist()] == EVENTS
+
+
+def test_read_jsonb_bad_version():
+    data = copy_text([(b'\x02{}',)])
+    with pytest.raises(pa.ArrowInvalid, match='jsonb version'):
+        parser.read_pg_buffer(io.BytesIO(data), ['e'], ['jsonb'])
+
+
+@pytest.mark.parametrize('field_type', ['json', 'jsonb'])
+def test_read_json_struct(field_type):
+    data = copy_text(json_rows(field_type == 'jsonb'))
+    event_type = pa.struct([('kind', pa.utf8()), ('x', pa.int32()), ('missing', pa.float64())])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['e'], [field_type], json_struct={'e': event_type})
+
+    assert table.schema.types == [event_type]
+    assert table.column('e').to_pylist() == [None if e is None else
+                                             {'kind': e['kind'], 'x': e['x'], 'missing': None} for e in EVENTS]
+
+    table = parser.read_pg_buffer(io.BytesIO(data), ['e'], [field_type], json_struct={'e': None})
+    assert table.schema.field('e').type.get_field_index('tags') != -1
+    assert table.column('e').to_pylist()[:2] == [{'kind': 'click', 'x': 10, 'tags': ['a', 'b'], 'extra': None},
+                                                 None]
+
+
+def test_read_json_struct_inferred_once():
+    data = copy_text(json_rows(False) * 40)
+    table = parser.read_pg_buffer(io.BytesIO(data), ['e'], ['json'], json_struct={'e': None},
+                                  parallel='chunks', chunk_size=1000)
+    assert table.column('e').num_chunks == 1
+    assert table.column('e').to_pylist()[3] == {'kind': 'scroll\nline', 'x': -3, 'tags': None, 'extra': None}
+
+    # batches of NULLs before the first object do not settle the type
+    rows = [(None,)] * 25 + [(json.dumps({'a': i}).encode(),) for i in range(25)]
+    decoder = parser.StreamDecoder(['e'], ['json'], batch_size=10, json_struct={'e': None})
+    decoder.write(copy_text(rows))
+    table = decoder.to_table()
+    assert table.schema.types == [pa.struct([('a', pa.int64())])]
+    assert table.column('e').to_pylist() == [None] * 25 + [{'a': i} for i in range(25)]
+
+
+def test_read_json_struct_errors():
+    with pytest.raises(ValueError, match='not of type json'):
+        parser.read_pg_buffer(io.BytesIO(copy_text([])), ['e'], ['text'], json_struct={'e': None})
+    data = copy_text([(b'[1, 2]',)])
+    with pytest.raises(pa.ArrowInvalid, match="column 'e'"):
+        parser.read_pg_buffer(io.BytesIO(data), ['e'], ['json'], json_struct={'e': None})
+
+
+def pg_hstore(pairs):
+    out = [struct.pack('!i', len(pairs))]
+    for key, value in pairs.items():
+        out.append(struct.pack('!i', len(key.encode())) + key.encode())
+        out.append(struct.pack('!i', -1) if value is None else struct.pack('!i', len(value.encode())) + value.encode())
+    return b''.join(out)
+
+
+def test_read_hstore():
+    tags = [{'site': 'north', 'kind': 'meter', 'note': None}, {}, None, {'ünï': 'cödé ' * 10}] * 30
+    data = copy_text([(None if t is None else pg_hstore(t),) for t in tags])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['tags'], ['hstore'])
+
+    assert table.schema.types == [pa.map_(pa.utf8(), pa.utf8())]
+    table.column('tags').chunk(0).validate(full=True)
+    assert table.column('tags').to_pylist() == [None if t is None else list(t.items()) for t in tags]
+
+
+def test_read_hstore_corrupt():
+    data = copy_text([(pg_hstore({'a': 'b'})[:-1],)])
+    with pytest.raises(pa.ArrowInvalid, match='corrupt hstore'):
+        parser.read_pg_buffer(io.BytesIO(data), ['tags'], ['hstore'])
+
+
+def test_read_geometric():
+    square = [(0.0, 0.0), (1.0, 0.0), (1.0, 1.0), (0.0, 1.0)]
+
+    def pg_points(points):
+        return b''.join(struct.pack('!dd', x, y) for x, y in points)
+
+    rows = [(pg_points([(1.5, -2.0)]), struct.pack('!dddd', 3, 4, 1, 2), pg_points(square[:2]),
+             struct.pack('!Bi', 1, 3) + pg_points(square[:3]), struct.pack('!i', 4) + pg_points(square),
+             struct.pack('!ddd', 1, -1, 0), struct.pack('!ddd', 0, 0, 2)),
+            (None,) * 7] * 40
+    names = ['point', 'box', 'lseg', 'path', 'polygon', 'line', 'circle']
+    table = parser.read_pg_buffer(io.BytesIO(copy_text(rows)), names, names)
+
+    def values(name):
+        chunk = table.column(name).chunk(0)
+        return (chunk.storage if isinstance(chunk, pa.ExtensionArray) else chunk).to_pylist()[:2]
+
+    def xy(points):
+        return [{'x': x, 'y': y} for x, y in points]
+
+    assert table.schema.field('point').type.extension_name == 'geoarrow.point'
+    assert table.schema.field('polygon').type.extension_name == 'geoarrow.polygon'
+    assert values('point') == [{'x': 1.5, 'y': -2.0}, None]
+    assert values('box') == [{'xmin': 1, 'ymin': 2, 'xmax': 3, 'ymax': 4}, None]
+    assert values('lseg') == [xy(square[:2]), None]
+    assert values('path') == [xy(square[:3] + square[:1]), None]
+    assert values('polygon') == [[xy(square + square[:1])], None]
+    assert values('line') == [{'a': 1, 'b': -1, 'c': 0}, None]
+    assert values('circle') == [{'x': 0, 'y': 0, 'radius': 2}, None]
+
+
+def test_read_postgis():
+    point = struct.pack('<BIidd', 1, 0x20000001, 4326, 5.0, 6.0)
+    line = struct.pack('>BIidddd', 0, 0x20000002, 4326, 0, 0, 1, 1)
+    data = copy_text([(point,), (line,), (None,)])
+    table = parser.read_pg_buffer(io.BytesIO(data), ['g'], ['geometry(Geometry, 4326)'])
+
+    field_type = table.schema.field('g').type
+    assert field_type.extension_name == 'geoarrow.wkb'
+    # the extension type is not registered, so reading it back gives the storage and the field metadata
+    metadata = pa.ipc.read_schema(table.schema.serialize()).field('g').metadata
+    assert json.loads(metadata[b'ARROW:extension:metadata']) == {'crs': '4326', 'crs_type': 'srid'}
+    assert table.column('g').chunk(0).storage.to_pylist() == [struct.pack('<BIdd', 1, 1, 5.0, 6.0),
+                                                              struct.pack('>BIdddd', 0, 2, 0, 0, 1, 1), None]
+
+    data = copy_text([(point,), (struct.pack('<BIidd', 1, 0x20000001, 3857, 5.0, 6.0),)])
+    with pytest.raises(pa.ArrowInvalid, match='SRID 3857 .* of SRID 4326'):
+        parser.read_pg_buffer(io.BytesIO(data), ['g'], ['geography'])
+
+
+def test_read_postgis_declared_srid():
+    def crs(schema):
+        return json.loads(pa.ipc.read_schema(schema.serialize()).field('g').metadata[b'ARROW:extension:metadata'])
+
+    point = struct.pack('<BIidd', 1, 0x20000001, 3857, 5.0, 6.0)
+    data = copy_text([(None,)] * 5 + [(point,)] * 5)
+    # the CRS comes from the declared type, not from the values
+    decoder = parser.StreamDecoder(['g'], ['geometry(Point, 3857)'], batch_size=2)
+    decoder.write(data)
+    table = decoder.to_table()
+    assert crs(table.schema) == {'crs': '3857', 'crs_type': 'srid'}
+    assert table.column('g').num_chunks == 5
+
+    table = parser.read_pg_buffer(io.BytesIO(data), ['g'], ['geometry'])
+    assert crs(table.schema) == {}
+    assert table.column('g').chunk(0).storage.to_pylist()[5] == struct.pack('<BIdd', 1, 1, 5.0, 6.0)
+
+
+@pytest.mark.parametrize('parallel', ['columns', 'chunks'])
+def test_read_bool(parallel):
+    flags = [i % 3 == 0 if i % 7 else None for i in range(1000)]
+    arrays = [[bool((i >> b) & 1) for b in range(i % 130)] for i in range(1000)]
+    rows = [(None if f is None else struct.pack('!?', f),
+             pg_array(16, [struct.pack('!?', v) for v in a], ndim=min(len(a), 1))) for f, a in zip(flags, arrays)]
+    table = parser.read_pg_buffer(io.BytesIO(copy_text(rows)), ['f', 'a'], ['bool', 'bool[]'], parallel=parallel,
+                                  chunk_size=1000)
+
+    assert table.schema.types == [pa.bool_(), pa.list_(pa.bool_())]
+    for chunk in table.column('f').chunks:
+        chunk.validate(full=True)
+    assert table.column('f').to_pylist() == flags
+    assert table.column('a').to_pylist() == arrays
+
+
+def test_read_bit():
+    def pg_bit(bits):
+        value = int(bits, 2) << (-len(bits) % 8) if bits else 0
+        return struct.pack('!i', len(bits)) + value.to_bytes((len(bits) + 7) // 8, 'big')
+
+    rows = [(pg_bit('1011001110'), pg_bit('101')), (None, pg_bit('')), (pg_bit('0000000001'), None)]
+    table = parser.read_pg_buffer(io.BytesIO(copy_text(rows)), ['b', 'v'], ['bit(10)', 'varbit'])
+
+    assert table.schema.types == [pa.binary(2), pa.struct([pa.field('bits', pa.binary(), False),
+                                                           pa.field('length', pa.int32(), False)])]
+    assert table.column('b').to_pylist() == [b'\xb3\x80', None, b'\x00\x40']
+    assert table.column('v').to_pylist() == [{'bits': b'\xa0', 'length': 3}, {'bits': b'', 'length': 0}, None]
+
+    with pytest.raises(pa.ArrowInvalid, match='bit\\(10\\)'):
+        parser.read_pg_buffer(io.BytesIO(copy_text([(pg_bit('101'),)])), ['b'], ['bit(10)'])